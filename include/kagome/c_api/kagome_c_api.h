@@ -35,6 +35,11 @@ typedef struct rspamd_ftok_unicode {
 #define RSPAMD_WORD_FLAG_INVISIBLE_SPACES (1u << 12u)
 #define RSPAMD_WORD_FLAG_EMOJI (1u << 13u)
 
+/* All strings of a word are given by begin and len only and are NOT
+ * NUL-terminated: original and unicode are slices of the input and the
+ * result, normalized and stemmed borrow dictionary base forms or input
+ * bytes, or hold the NFKC form of a surface rewritten by normalization in
+ * the result. Read them with their len, never with strlen() or "%s". */
 typedef struct rspamd_word {
 	rspamd_ftok_t original;
 	rspamd_ftok_unicode_t unicode;
@@ -43,12 +48,36 @@ typedef struct rspamd_word {
 	unsigned int flags;
 } rspamd_word_t;
 
+/* Results of this library are read-only: a points into a block that also
+ * holds the words' UTF-32 storage, so it is not a kvec allocation of its
+ * own and m is 0. Never kv_push, kv_resize, realloc or free a result;
+ * release it only with kagome_cleanup_result. */
 typedef struct rspamd_words_s {
 	size_t n;
 	size_t m;
 	rspamd_word_t *a;
 } rspamd_words_t;
 
+/* Token of the hashed output mode; offset and len give the surface in the
+ * input, hash is kagome_hash() of the normalized form (the dictionary base
+ * form when the entry has one, otherwise the surface, in NFKC when
+ * normalization is enabled) */
+typedef struct kagome_hashed_token {
+	uint64_t hash;
+	uint32_t offset;
+	uint32_t len;
+	uint32_t flags; /* RSPAMD_WORD_FLAG_* */
+	uint32_t reserved;
+} kagome_hashed_token_t;
+
+/* Read-only like rspamd_words_t: m is 0, release only with
+ * kagome_cleanup_hashed_result */
+typedef struct kagome_hashed_tokens {
+	size_t n;
+	size_t m;
+	kagome_hashed_token_t *a;
+} kagome_hashed_tokens_t;
+
 /* Forward declarations */
 typedef struct ucl_object_s ucl_object_t;
 
@@ -58,7 +87,47 @@ typedef struct kagome_tokenizer_handle kagome_tokenizer_handle_t;
 /* C API functions */
 
 /**
- * Initialize the kagome tokenizer
+ * Create a tokenizer instance. Instances configured with the same
+ * dictionary and POS rules share one read-only copy of it, loaded by the
+ * first one. An instance may be used from any number of threads at once;
+ * every call gets its own analysis state.
+ * @param config UCL configuration object (can be NULL); see
+ *        kagome/c_api/options.hpp for the recognised keys
+ * @param error_buf Buffer for error messages
+ * @param error_buf_size Size of error buffer
+ * @return New instance, or NULL on failure
+ */
+kagome_tokenizer_handle_t *kagome_create(const ucl_object_t *config, char *error_buf,
+										 size_t error_buf_size);
+
+/**
+ * Destroy a tokenizer instance created by kagome_create. Results already
+ * returned by it must not be used afterwards.
+ * @param handle Instance to destroy (can be NULL)
+ */
+void kagome_destroy(kagome_tokenizer_handle_t *handle);
+
+/**
+ * Tokenize Japanese text with the given instance, as kagome_tokenize does
+ */
+int kagome_tokenize_h(kagome_tokenizer_handle_t *handle, const char *text, size_t len,
+					  rspamd_words_t *result);
+
+/**
+ * Detect and tokenize with the given instance, as kagome_detect_and_tokenize does
+ */
+int kagome_detect_and_tokenize_h(kagome_tokenizer_handle_t *handle, const char *text, size_t len,
+								 double min_confidence, double *confidence, rspamd_words_t *result);
+
+/**
+ * Tokenize a batch of texts with the given instance, as kagome_tokenize_batch does
+ */
+int kagome_tokenize_batch_h(kagome_tokenizer_handle_t *handle, const char *const *texts,
+							const size_t *lens, size_t count, rspamd_words_t *results);
+
+/**
+ * Initialize the global tokenizer instance used by the functions below
+ * that take no handle
  * @param config UCL configuration object (can be NULL)
  * @param error_buf Buffer for error messages
  * @param error_buf_size Size of error buffer
@@ -67,33 +136,178 @@ typedef struct kagome_tokenizer_handle kagome_tokenizer_handle_t;
 int kagome_init(const ucl_object_t *config, char *error_buf, size_t error_buf_size);
 
 /**
- * Cleanup the kagome tokenizer
+ * Destroy the global tokenizer instance
  */
 void kagome_deinit(void);
 
 /**
- * Detect if text is Japanese
+ * Detect if text is Japanese, sampling the global instance's
+ * detect_max_bytes when one is configured
  * @param text UTF-8 text to analyze
  * @param len Length of text in bytes
  * @return Confidence score 0.0-1.0, or -1.0 if cannot handle
  */
 double kagome_detect_language(const char *text, size_t len);
 
+/**
+ * Detect if text is Japanese, scanning at most about max_scan_bytes of it
+ * in evenly spaced windows. Intended for multi-megabyte parts; the result
+ * follows the same confidence curve but is estimated from the sample.
+ * @param text UTF-8 text to analyze
+ * @param len Length of text in bytes
+ * @param max_scan_bytes Scan limit in bytes, 0 to scan everything
+ * @return Confidence score 0.0-1.0, or -1.0 if cannot handle
+ */
+double kagome_detect_language_sampled(const char *text, size_t len, size_t max_scan_bytes);
+
 /**
  * Tokenize Japanese text
  * @param text UTF-8 text to tokenize
  * @param len Length of text in bytes
- * @param result Output kvec to fill with rspamd_word_t elements
+ * @param result Output kvec to fill with rspamd_word_t elements; the
+ *        normalized and stemmed forms point into the dictionary, into text
+ *        or (for surfaces rewritten by normalization) into the result, so
+ *        they stay valid until kagome_deinit(), text or the result is
+ *        released; like all word strings they are not NUL-terminated (see
+ *        rspamd_word_t)
  * @return 0 on success, non-zero on failure
  */
 int kagome_tokenize(const char *text, size_t len, rspamd_words_t *result);
 
 /**
- * Cleanup tokenization result
+ * Detect if text is Japanese and tokenize it in the same call. The
+ * detection scan is reused by tokenization, so the text is not scanned
+ * for scripts twice as with kagome_detect_language + kagome_tokenize.
+ * @param text UTF-8 text to analyze
+ * @param len Length of text in bytes
+ * @param min_confidence Text is only tokenized when its confidence is at
+ *        least this (see kagome_get_min_confidence)
+ * @param confidence Output for the detection confidence as returned by
+ *        kagome_detect_language (can be NULL)
+ * @param result Output kvec, filled as by kagome_tokenize; left empty when
+ *        the text is not tokenized
+ * @return 0 on success, non-zero on failure
+ */
+int kagome_detect_and_tokenize(const char *text, size_t len, double min_confidence,
+							   double *confidence, rspamd_words_t *result);
+
+/**
+ * Tokenize a batch of texts on a shared worker pool
+ * @param texts Array of UTF-8 texts
+ * @param lens Array of text lengths in bytes
+ * @param count Number of texts
+ * @param results Array of count kvecs; each is filled as by kagome_tokenize,
+ *        with its own budget, and must be released with kagome_cleanup_result
+ * @return 0 on success, non-zero if any text failed (its result is left empty)
+ */
+int kagome_tokenize_batch(const char *const *texts, const size_t *lens, size_t count,
+						  rspamd_words_t *results);
+
+/**
+ * Cleanup tokenization result. All buffers of a result share one block
+ * behind result->a, so it must only be released through this function.
+ * A result whose n, m or a were changed since it was returned is not
+ * released (debug builds assert), as freeing it could corrupt the heap.
  * @param result Result kvec from kagome_tokenize
  */
 void kagome_cleanup_result(rspamd_words_t *result);
 
+/* Result cache counters; entries and bytes are current values */
+typedef struct kagome_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t insertions;
+	uint64_t evictions;
+	size_t entries;
+	size_t bytes;
+} kagome_cache_stats_t;
+
+/**
+ * Get the result cache counters of an instance created with a non-zero
+ * result_cache_bytes option
+ * @param handle Tokenizer instance
+ * @param stats Receives the counters
+ * @return 0 on success, -1 if the instance has no result cache
+ */
+int kagome_get_cache_stats_h(kagome_tokenizer_handle_t *handle, kagome_cache_stats_t *stats);
+
+/**
+ * Get the result cache counters of the global instance
+ * @param stats Receives the counters
+ * @return 0 on success, -1 if there is no result cache
+ */
+int kagome_get_cache_stats(kagome_cache_stats_t *stats);
+
+/**
+ * Get the sentence chunk cache counters of an instance created with a
+ * non-zero chunk_cache_bytes option
+ * @param handle Tokenizer instance
+ * @param stats Receives the counters
+ * @return 0 on success, -1 if the instance has no chunk cache
+ */
+int kagome_get_chunk_cache_stats_h(kagome_tokenizer_handle_t *handle, kagome_cache_stats_t *stats);
+
+/**
+ * Get the sentence chunk cache counters of the global instance
+ * @param stats Receives the counters
+ * @return 0 on success, -1 if there is no chunk cache
+ */
+int kagome_get_chunk_cache_stats(kagome_cache_stats_t *stats);
+
+/**
+ * Tokenize Japanese text into hashed tokens only, without strings or
+ * UTF-32 copies: one allocation per call holds the whole array. Hashes of
+ * dictionary base forms are precomputed when the dictionary is loaded.
+ * @param handle Tokenizer instance
+ * @param text UTF-8 text to tokenize (less than 4 GiB)
+ * @param len Length of text in bytes
+ * @param result Output array, released with kagome_cleanup_hashed_result
+ * @return 0 on success, non-zero on failure
+ */
+int kagome_tokenize_hashed_h(kagome_tokenizer_handle_t *handle, const char *text, size_t len,
+							 kagome_hashed_tokens_t *result);
+
+/**
+ * Tokenize Japanese text into hashed tokens with the global instance
+ */
+int kagome_tokenize_hashed(const char *text, size_t len, kagome_hashed_tokens_t *result);
+
+/**
+ * Free a result returned by kagome_tokenize_hashed(_h)
+ * @param result Result to free (can be empty)
+ */
+void kagome_cleanup_hashed_result(kagome_hashed_tokens_t *result);
+
+/**
+ * Whether a result of kagome_tokenize(_h), kagome_detect_and_tokenize(_h)
+ * or kagome_tokenize_batch(_h) was cut short by the max_edges or
+ * time_budget_us option: past the point where the budget ran out, the text
+ * is split by character class only. Degraded results are never put in
+ * the result cache, so a later call with the same text is analyzed again.
+ * @param result Result to check (can be empty)
+ * @return 1 if degraded, 0 otherwise
+ */
+int kagome_result_is_degraded(const rspamd_words_t *result);
+
+/**
+ * Whether a result of kagome_tokenize_hashed(_h) was cut short, as
+ * kagome_result_is_degraded
+ */
+int kagome_hashed_result_is_degraded(const kagome_hashed_tokens_t *result);
+
+/**
+ * 64-bit hash used for hashed tokens, e.g. to hash words of other
+ * tokenizers consistently. The algorithm is fixed so that values may be
+ * stored: wyhash final4 with seed 0 and the default wyhash final4 secret
+ * {0xa0761d6478bd642f, 0xe7037ed1a0b428db, 0x8ebc6af09c88c6e3,
+ * 0x589965cc75374cc3}, reading input as little-endian on every platform.
+ * For example kagome_hash("", 0) is 0x0409638ee2bde459.
+ * @param data Bytes to hash
+ * @param len Number of bytes
+ * @return Hash value
+ */
+uint64_t kagome_hash(const char *data, size_t len);
+
 /**
  * Get language hint
  * @return Language code "ja" for Japanese
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "kagome/c_api/kagome_c_api.h"
+#include "kagome/dict/dict.hpp"
+#include "kagome/tokenizer/tokenizer.hpp"
+
+namespace kagome::c_api {
+
+/// Settings of one tokenizer instance, read from the plugin's UCL config.
+///
+/// Recognised keys (all optional):
+///   dictionary          path to the system dictionary (default: search the usual locations)
+///   dictionary_type     "ipa" or "uni"
+///   user_dictionary     path to a user dictionary in kagome's CSV format
+///   mode                "normal", "search" or "extended"
+///   max_input_bytes     tokenize at most this many bytes of a text (0 = all)
+///   beam_width          Viterbi beam per position (0 = exact search)
+///   stop_word_pos       POS prefixes flagged as stop words, e.g. ["助詞", "名詞,非自立"]
+///   punctuation_pos     POS prefixes flagged as punctuation
+///   script_prepass      keep ASCII runs out of the lattice
+///   share_dictionary    share one loaded dictionary between instances with equal settings
+///   batch_threads       worker threads for batch tokenization (0 = hardware concurrency)
+///   detect_max_bytes    bytes sampled by language detection (0 = whole text)
+///   result_cache_bytes  memory for caching results of repeated texts (0 = no cache)
+///   chunk_cache_bytes   memory for caching tokens of recurring sentences (0 = no cache)
+///   max_edges           lattice edges evaluated per text before degrading (0 = unlimited)
+///   time_budget_us      microseconds spent per text before degrading (0 = unlimited)
+///   normalize           analyze the NFKC form of texts (full-width Latin, half-width kana)
+struct Options {
+	std::string dictionary;
+	tokenizer::DictType dictionary_type = tokenizer::DictType::IPA;
+	std::string user_dictionary;
+	tokenizer::TokenizeMode mode = tokenizer::TokenizeMode::Normal;
+	std::size_t max_input_bytes = 0;
+	std::size_t beam_width = 0;
+	/// Rules for the entry flags; the defaults unless stop_word_pos or
+	/// punctuation_pos replaced the rules of their flag
+	std::vector<dict::PosFlagRule> pos_flag_rules;
+	bool script_prepass = true;
+	bool share_dictionary = true;
+	std::size_t batch_threads = 0;
+	std::size_t detect_max_bytes = 0;
+	std::size_t result_cache_bytes = 0;
+	std::size_t chunk_cache_bytes = 0;
+	std::size_t max_edges = 0;
+	std::size_t time_budget_us = 0;
+	bool normalize = false;
+
+	Options();
+
+	/// Whether pos_flag_rules differ from dict::default_pos_flag_rules()
+	[[nodiscard]] bool custom_pos_flag_rules() const;
+
+	/// Tokenizer configuration for these options
+	[[nodiscard]] tokenizer::TokenizerConfig tokenizer_config() const;
+};
+
+/// Read options from a UCL object; nullptr yields the defaults. Throws
+/// std::runtime_error for values of the wrong type or out of range.
+/// Without libucl loaded into the process the config is ignored.
+[[nodiscard]] Options parse_options(const ucl_object_t *config);
+
+/// Whether the UCL functions are available to parse_options()
+[[nodiscard]] bool ucl_available() noexcept;
+
+}// namespace kagome::c_api
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace kagome::common {
+
+/// Secret of the wyhash final4 release (its default _wyp)
+inline constexpr std::array<std::uint64_t, 4> HASH_SECRET = {
+	0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
+
+/// Seed of hash_bytes()
+inline constexpr std::uint64_t HASH_SEED = 0;
+
+namespace detail {
+
+/// 64x64 -> 128 bit multiply; lo and hi receive the halves of the product
+inline void wymum(std::uint64_t &lo, std::uint64_t &hi) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+	__extension__ typedef unsigned __int128 uint128;
+	const uint128 product = static_cast<uint128>(lo) * hi;
+	lo = static_cast<std::uint64_t>(product);
+	hi = static_cast<std::uint64_t>(product >> 64);
+#else
+	const std::uint64_t ha = lo >> 32, hb = hi >> 32, la = static_cast<std::uint32_t>(lo),
+						lb = static_cast<std::uint32_t>(hi);
+	const std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	const std::uint64_t t = rl + (rm0 << 32);
+	std::uint64_t carry = t < rl;
+	const std::uint64_t low = t + (rm1 << 32);
+	carry += low < t;
+	hi = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+	lo = low;
+#endif
+}
+
+inline std::uint64_t wymix(std::uint64_t a, std::uint64_t b) noexcept
+{
+	wymum(a, b);
+	return a ^ b;
+}
+
+/// Little-endian reads, so hashes are the same on every platform
+inline std::uint64_t wyr8(const std::uint8_t *p) noexcept
+{
+	std::uint64_t v;
+	std::memcpy(&v, p, sizeof(v));
+	if constexpr (std::endian::native == std::endian::big) {
+		v = std::byteswap(v);
+	}
+	return v;
+}
+
+inline std::uint64_t wyr4(const std::uint8_t *p) noexcept
+{
+	std::uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	if constexpr (std::endian::native == std::endian::big) {
+		v = std::byteswap(v);
+	}
+	return v;
+}
+
+inline std::uint64_t wyr3(const std::uint8_t *p, std::size_t k) noexcept
+{
+	return (static_cast<std::uint64_t>(p[0]) << 16) | (static_cast<std::uint64_t>(p[k >> 1]) << 8) | p[k - 1];
+}
+
+}// namespace detail
+
+/// wyhash (final4 release) of bytes with the given seed and secret
+[[nodiscard]] inline std::uint64_t wyhash(std::string_view bytes, std::uint64_t seed,
+										  const std::array<std::uint64_t, 4> &secret) noexcept
+{
+	using namespace detail;
+
+	const auto *p = reinterpret_cast<const std::uint8_t *>(bytes.data());
+	const std::size_t len = bytes.size();
+	seed ^= wymix(seed ^ secret[0], secret[1]);
+	std::uint64_t a = 0;
+	std::uint64_t b = 0;
+
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (wyr4(p) << 32) | wyr4(p + ((len >> 3) << 2));
+			b = (wyr4(p + len - 4) << 32) | wyr4(p + len - 4 - ((len >> 3) << 2));
+		}
+		else if (len > 0) {
+			a = wyr3(p, len);
+		}
+	}
+	else {
+		std::size_t i = len;
+		if (i >= 48) {
+			std::uint64_t see1 = seed;
+			std::uint64_t see2 = seed;
+			do {
+				seed = wymix(wyr8(p) ^ secret[1], wyr8(p + 8) ^ seed);
+				see1 = wymix(wyr8(p + 16) ^ secret[2], wyr8(p + 24) ^ see1);
+				see2 = wymix(wyr8(p + 32) ^ secret[3], wyr8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i >= 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = wymix(wyr8(p) ^ secret[1], wyr8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = wyr8(p + i - 16);
+		b = wyr8(p + i - 8);
+	}
+
+	a ^= secret[1];
+	b ^= seed;
+	wymum(a, b);
+	return wymix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+/// 64-bit hash of a byte string: wyhash final4 with HASH_SEED and
+/// HASH_SECRET, kept in-tree so that the values do not depend on any
+/// library version. Used for cache keys and for the token hashes handed
+/// to callers (kagome_hash()), which may be stored across builds.
+[[nodiscard]] inline std::uint64_t hash_bytes(std::string_view bytes) noexcept
+{
+	return wyhash(bytes, HASH_SEED, HASH_SECRET);
+}
+
+}// namespace kagome::common
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kagome::common {
+
+/// Text in Unicode NFKC with a map from its byte offsets back to the
+/// original text. Reusable: normalize_nfkc() keeps the buffers around.
+class NormalizedText {
+public:
+	/// The normalized text; views the original when nothing changed
+	[[nodiscard]] std::string_view text() const noexcept
+	{
+		return text_;
+	}
+
+	/// Whether normalization changed anything
+	[[nodiscard]] bool changed() const noexcept
+	{
+		return !edits_.empty();
+	}
+
+	/// Original offset of the byte at offset of text(). Offsets inside a
+	/// rewritten character map to its start.
+	[[nodiscard]] std::int32_t original_start(std::int32_t offset) const noexcept;
+
+	/// Original offset just past the byte before offset of text(). Offsets
+	/// inside a rewritten character map to its end, so a span of text()
+	/// always maps to whole original characters.
+	[[nodiscard]] std::int32_t original_end(std::int32_t offset) const noexcept;
+
+private:
+	/// A rewritten span: text()[begin, end) replaces original[original_begin, original_end)
+	struct Edit {
+		std::int32_t begin = 0;
+		std::int32_t end = 0;
+		std::int32_t original_begin = 0;
+		std::int32_t original_end = 0;
+	};
+
+	std::string_view text_;
+	std::string buffer_;
+	std::vector<Edit> edits_;
+	/// Scratch space for ICU, which normalizes UTF-16
+	std::u16string utf16_;
+	std::u16string normalized_utf16_;
+
+	/// Offset of text() mapped through the last edit ending at or before it
+	[[nodiscard]] std::int32_t shift(std::int32_t offset) const noexcept;
+
+	friend void normalize_nfkc(std::string_view input, NormalizedText &out);
+};
+
+/// Normalize UTF-8 input to NFKC into out, folding full-width Latin,
+/// half-width katakana and other compatibility characters. Only the
+/// characters that can change are handed to ICU: ASCII runs are skipped in
+/// bulk and other BMP characters are checked against a bitmap built once
+/// from ICU, so already normalized text is not copied. Invalid UTF-8
+/// sequences are kept as they are. out.text() views input when unchanged.
+void normalize_nfkc(std::string_view input, NormalizedText &out);
+
+}// namespace kagome::common
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "kagome/common/utf8.hpp"
+
+namespace kagome::common {
+
+/// Character counts gathered by a Japanese script scan
+struct ScriptCounts {
+	/// Characters scanned (invalid UTF-8 sequences count as one each)
+	std::size_t total_chars = 0;
+	/// Hiragana, Katakana and Han characters among them
+	std::size_t japanese_chars = 0;
+};
+
+/// Whether a code point is Hiragana, Katakana or Han according to ICU.
+/// BMP code points are answered from a bitmap built once from ICU.
+[[nodiscard]] bool is_japanese_script(char32_t codepoint) noexcept;
+
+/// Count characters and Japanese characters of text in a single pass.
+/// ASCII runs are skipped in bulk since they never contain Japanese.
+[[nodiscard]] ScriptCounts count_japanese_chars(std::string_view text) noexcept;
+
+/// Like count_japanese_chars(), and also splits text into ASCII and
+/// non-ASCII runs on the way so later passes need not scan it again
+[[nodiscard]] ScriptCounts count_japanese_chars(std::string_view text, std::vector<ByteRun> &runs);
+
+/// Like count_japanese_chars(), but scans at most about max_scan_bytes
+/// spread evenly over text in windows aligned to character boundaries.
+/// max_scan_bytes = 0 or a text no longer than it scans everything.
+[[nodiscard]] ScriptCounts sample_japanese_chars(std::string_view text,
+												 std::size_t max_scan_bytes) noexcept;
+
+/// Detection confidence for counts: -1.0 without any Japanese character,
+/// otherwise 0.3 + 0.65 * ratio clamped to [0.3, 0.95]
+[[nodiscard]] double japanese_confidence(const ScriptCounts &counts) noexcept;
+
+}// namespace kagome::common
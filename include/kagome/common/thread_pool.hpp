@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kagome::common {
+
+/// Fixed-size work-stealing thread pool.
+///
+/// Each worker owns a task deque: it pops its own tasks LIFO and steals from
+/// the other deques FIFO when it runs dry. Callers of parallel_for() also
+/// execute tasks while they wait, so nested parallel_for() calls from inside a
+/// task cannot deadlock the pool.
+class ThreadPool {
+public:
+	/// Create a pool with the given number of worker threads (0 = hardware concurrency)
+	explicit ThreadPool(std::size_t threads = 0);
+	~ThreadPool();
+
+	// Non-copyable and non-movable (workers reference the pool)
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+	ThreadPool(ThreadPool &&) = delete;
+	ThreadPool &operator=(ThreadPool &&) = delete;
+
+	/// Number of worker threads
+	[[nodiscard]] std::size_t size() const noexcept
+	{
+		return threads_.size();
+	}
+
+	/// Run fn(i) for every i in [0, count) and wait until all calls finish.
+	/// The first exception thrown by fn is rethrown in the calling thread.
+	void parallel_for(std::size_t count, const std::function<void(std::size_t)> &fn);
+
+private:
+	/// Completion state shared by the tasks of one parallel_for() call
+	struct Batch {
+		const std::function<void(std::size_t)> *fn = nullptr;
+		std::atomic<std::size_t> remaining{0};
+		std::mutex mutex;
+		std::condition_variable done;
+		std::exception_ptr error;
+	};
+
+	struct Task {
+		Batch *batch = nullptr;
+		std::size_t index = 0;
+	};
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> threads_;
+
+	std::mutex wake_mutex_;
+	std::condition_variable wake_;
+	/// Tasks in all queues; idle workers block on wake_ while it is zero
+	std::atomic<std::size_t> queued_{0};
+	bool stop_ = false;
+
+	/// Pop a task from queue `own` or steal one from another queue
+	bool try_pop(std::size_t own, Task &task);
+
+	/// Execute a single task and signal its batch when it was the last one
+	static void run_task(const Task &task);
+
+	void worker_loop(std::size_t id);
+};
+
+}// namespace kagome::common
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace kagome::common {
+
+/// A maximal run of ASCII or of non-ASCII bytes within a text
+struct ByteRun {
+	std::size_t offset = 0;
+	std::size_t length = 0;
+	bool ascii = true;
+};
+
+/// Bitmask with the high bit of every byte of a 64-bit word set
+constexpr std::uint64_t HIGH_BITS_MASK = 0x8080808080808080ULL;
+
+/// Length of the leading run of ASCII bytes in [data, data + len).
+/// Scans 16 bytes at a time with SSE2, or 8 bytes at a time elsewhere.
+inline std::size_t ascii_prefix_length(const char *data, std::size_t len) noexcept
+{
+	std::size_t pos = 0;
+
+#if defined(__SSE2__)
+	for (; pos + 16 <= len; pos += 16) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+		auto mask = static_cast<unsigned int>(_mm_movemask_epi8(chunk));
+		if (mask != 0) {
+			return pos + static_cast<std::size_t>(__builtin_ctz(mask));
+		}
+	}
+#endif
+
+	for (; pos + 8 <= len; pos += 8) {
+		std::uint64_t word;
+		std::memcpy(&word, data + pos, sizeof(word));
+		if ((word & HIGH_BITS_MASK) != 0) {
+			break;
+		}
+	}
+
+	while (pos < len && static_cast<unsigned char>(data[pos]) < 0x80) {
+		++pos;
+	}
+
+	return pos;
+}
+
+/// Length of the leading run of non-ASCII bytes in [data, data + len)
+inline std::size_t non_ascii_prefix_length(const char *data, std::size_t len) noexcept
+{
+	std::size_t pos = 0;
+
+#if defined(__SSE2__)
+	for (; pos + 16 <= len; pos += 16) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+		auto mask = static_cast<unsigned int>(_mm_movemask_epi8(chunk)) ^ 0xFFFFu;
+		if (mask != 0) {
+			return pos + static_cast<std::size_t>(__builtin_ctz(mask));
+		}
+	}
+#endif
+
+	for (; pos + 8 <= len; pos += 8) {
+		std::uint64_t word;
+		std::memcpy(&word, data + pos, sizeof(word));
+		if ((word & HIGH_BITS_MASK) != HIGH_BITS_MASK) {
+			break;
+		}
+	}
+
+	while (pos < len && static_cast<unsigned char>(data[pos]) >= 0x80) {
+		++pos;
+	}
+
+	return pos;
+}
+
+}// namespace kagome::common
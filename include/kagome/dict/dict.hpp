@@ -1,10 +1,12 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <span>
 #include <memory>
+#include <optional>
 #include <cstdint>
 #include <functional>
 #include <unordered_map>
@@ -78,7 +80,7 @@ public:
 	// Search functions
 	std::vector<int> search(const std::string &input) const;
 	std::vector<std::pair<std::vector<int>, int>> common_prefix_search(const std::string &input) const;
-	void common_prefix_search_callback(const std::string &input,
+	void common_prefix_search_callback(std::string_view input,
 									   std::function<void(int, int)> callback) const;
 
 private:
@@ -153,6 +155,71 @@ enum class CharacterCategory : std::uint8_t {
 	Cyrillic = 9
 };
 
+/// Feature column indices resolved from contents metadata, so that token
+/// feature accessors do not look keys up per call
+struct FeatureColumns {
+	/// Column is not described by the metadata
+	static constexpr std::int32_t NO_COLUMN = -1;
+
+	std::int32_t pos_start = NO_COLUMN;
+	std::int32_t pos_hierarchy = NO_COLUMN;
+	std::int32_t inflectional_type = NO_COLUMN;
+	std::int32_t inflectional_form = NO_COLUMN;
+	std::int32_t base_form = NO_COLUMN;
+	std::int32_t reading = NO_COLUMN;
+	std::int32_t pronunciation = NO_COLUMN;
+
+	/// Resolve all columns from a contents metadata map
+	[[nodiscard]] static FeatureColumns
+	resolve(const ankerl::unordered_dense::map<std::string, std::uint32_t> &meta);
+};
+
+/// Append-only pool of NUL-terminated strings in one buffer. Strings are
+/// never moved once the pool is built, so views into it stay valid for the
+/// lifetime of the owning dictionary.
+class StringPool {
+public:
+	/// Append a string and return its ID (no deduplication)
+	std::uint32_t add(std::string_view str);
+
+	/// Get a string by ID; the view is followed by a NUL byte
+	[[nodiscard]] std::string_view get(std::uint32_t id) const noexcept
+	{
+		return std::string_view(data_.data() + offsets_[id], offsets_[id + 1] - offsets_[id] - 1);
+	}
+
+	/// Number of strings in the pool
+	[[nodiscard]] std::size_t size() const noexcept
+	{
+		return offsets_.size() - 1;
+	}
+
+	void clear()
+	{
+		data_.clear();
+		offsets_.assign(1, 0);
+	}
+
+private:
+	std::string data_;
+	/// Start offset of each string, plus the end of the buffer
+	std::vector<std::uint32_t> offsets_{0};
+};
+
+/// Entry classification flags, precomputed per dictionary entry
+constexpr std::uint8_t ENTRY_FLAG_PUNCTUATION = 1u << 0;
+constexpr std::uint8_t ENTRY_FLAG_STOP_WORD = 1u << 1;
+
+/// Assigns flags to entries whose POS hierarchy starts with pos_prefix
+struct PosFlagRule {
+	std::vector<std::string> pos_prefix;
+	std::uint8_t flags = 0;
+};
+
+/// Default rules for IPA-style POS tags: symbols are punctuation,
+/// particles and auxiliary verbs are stop words
+[[nodiscard]] std::span<const PosFlagRule> default_pos_flag_rules();
+
 /// Unknown word dictionary
 struct UnknownDict {
 	/// Content metadata
@@ -188,6 +255,22 @@ struct UserDict {
 	PrefixIndex index;
 };
 
+/// Character categories spanning more ASCII ranges than this have no
+/// AsciiCategoryRanges entry
+constexpr std::size_t MAX_ASCII_CATEGORY_RANGES = 4;
+
+/// The ASCII bytes of one character category as inclusive byte ranges
+struct AsciiCategoryRanges {
+	struct Range {
+		std::uint8_t lo = 0;
+		std::uint8_t hi = 0;
+	};
+
+	/// Number of ranges; 0 if the category has no ASCII bytes or too many ranges
+	std::uint8_t count = 0;
+	std::array<Range, MAX_ASCII_CATEGORY_RANGES> ranges{};
+};
+
 /// Main dictionary class
 class Dict {
 private:
@@ -203,9 +286,24 @@ public:
 	/// Content metadata for feature extraction
 	ankerl::unordered_dense::map<std::string, std::uint32_t> contents_meta;
 
+	/// Feature columns resolved from contents_meta
+	FeatureColumns columns;
+
 	/// Dictionary contents (features for each entry)
 	std::vector<std::vector<std::string>> contents;
 
+	/// Classification flags per entry (ENTRY_FLAG_*), see classify_entries()
+	std::vector<std::uint8_t> entry_flags;
+
+	/// Interned base forms shared by system and unknown entries
+	StringPool base_form_pool;
+
+	/// Base form of each entry as an ID into base_form_pool, see intern_base_forms()
+	std::vector<std::uint32_t> base_form_ids;
+
+	/// common::hash_bytes() of each base_form_pool string, by pool ID
+	std::vector<std::uint64_t> base_form_hashes;
+
 	/// Connection cost matrix
 	ConnectionTable connection;
 
@@ -218,13 +316,19 @@ public:
 	std::vector<bool> invoke_list;
 	std::vector<bool> group_list;
 
+	/// ASCII ranges of each character category, see build_ascii_category_ranges()
+	std::array<AsciiCategoryRanges, 256> ascii_category_ranges{};
+
 	/// Unknown word dictionary
 	struct UnkDict {
 		std::vector<Morph> morphs;
 		std::unordered_map<int32_t, int32_t> index;
 		std::unordered_map<int32_t, int32_t> index_dup;
 		ankerl::unordered_dense::map<std::string, std::uint32_t> contents_meta;
+		FeatureColumns columns;
 		std::vector<std::vector<std::string>> contents;
+		std::vector<std::uint8_t> entry_flags;
+		std::vector<std::uint32_t> base_form_ids;
 	} unk_dict;
 
 	Dict() = default;
@@ -269,6 +373,88 @@ public:
 		return idx < group_list.size() ? group_list[idx] : false;
 	}
 
+	/// Resolve feature columns of the system and unknown word dictionaries.
+	/// Must be called again whenever contents_meta changes.
+	void resolve_feature_columns();
+
+	/// Feature of a system dictionary entry; features are the entry's POS
+	/// names followed by its contents row
+	[[nodiscard]] std::optional<std::string_view> known_feature(std::int32_t id, std::size_t index) const;
+
+	/// Feature of an unknown word entry
+	[[nodiscard]] std::optional<std::string_view> unknown_feature(std::int32_t id, std::size_t index) const;
+
+	/// Base form of an entry: the base form column when the metadata names
+	/// one and it is set, otherwise the IPA base form position, otherwise "*"
+	[[nodiscard]] std::string_view entry_base_form(bool unknown, std::int32_t id) const;
+
+	/// Build base_form_pool and the base form ID columns for all entries
+	void intern_base_forms();
+
+	/// Split the ASCII block into maximal runs of one category and record
+	/// them in ascii_category_ranges. Must be called again whenever
+	/// char_category changes.
+	void build_ascii_category_ranges();
+
+	/// Interned base form of a system dictionary entry (NUL-terminated),
+	/// or std::nullopt when the base forms are not interned
+	[[nodiscard]] std::optional<std::string_view> known_base_form(std::int32_t id) const noexcept
+	{
+		if (static_cast<std::size_t>(id) >= base_form_ids.size()) {
+			return std::nullopt;
+		}
+		return base_form_pool.get(base_form_ids[id]);
+	}
+
+	/// Interned base form of an unknown word entry
+	[[nodiscard]] std::optional<std::string_view> unknown_base_form(std::int32_t id) const noexcept
+	{
+		if (static_cast<std::size_t>(id) >= unk_dict.base_form_ids.size()) {
+			return std::nullopt;
+		}
+		return base_form_pool.get(unk_dict.base_form_ids[id]);
+	}
+
+	/// Hash of the base form of a system dictionary entry
+	[[nodiscard]] std::optional<std::uint64_t> known_base_form_hash(std::int32_t id) const noexcept
+	{
+		if (static_cast<std::size_t>(id) >= base_form_ids.size()) {
+			return std::nullopt;
+		}
+		return base_form_hashes[base_form_ids[id]];
+	}
+
+	/// Hash of the base form of an unknown word entry
+	[[nodiscard]] std::optional<std::uint64_t> unknown_base_form_hash(std::int32_t id) const noexcept
+	{
+		if (static_cast<std::size_t>(id) >= unk_dict.base_form_ids.size()) {
+			return std::nullopt;
+		}
+		return base_form_hashes[unk_dict.base_form_ids[id]];
+	}
+
+	/// POS hierarchy of a system dictionary entry, as views into the dictionary
+	[[nodiscard]] std::vector<std::string_view> known_pos(std::int32_t id) const;
+
+	/// POS hierarchy of an unknown word entry, as views into the dictionary
+	[[nodiscard]] std::vector<std::string_view> unknown_pos(std::int32_t id) const;
+
+	/// Recompute entry_flags of all known and unknown entries. Flags of every
+	/// rule whose prefix matches the entry's POS are combined.
+	void classify_entries(std::span<const PosFlagRule> rules = default_pos_flag_rules());
+
+	/// Classification flags of a system dictionary entry
+	[[nodiscard]] std::uint8_t known_flags(std::int32_t id) const noexcept
+	{
+		return static_cast<std::size_t>(id) < entry_flags.size() ? entry_flags[id] : 0;
+	}
+
+	/// Classification flags of an unknown word entry
+	[[nodiscard]] std::uint8_t unknown_flags(std::int32_t id) const noexcept
+	{
+		return static_cast<std::size_t>(id) < unk_dict.entry_flags.size() ? unk_dict.entry_flags[id] : 0;
+	}
+
 	/// Load dictionary from file/data (legacy)
 	bool load_from_file(const std::string &filepath);
 
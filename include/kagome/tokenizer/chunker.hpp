@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace kagome::tokenizer {
+
+/// Default upper bound on the size of a single chunk in bytes
+constexpr std::size_t DEFAULT_MAX_CHUNK_BYTES = 16 * 1024;
+
+/// A slice of the input that can be tokenized independently
+struct Chunk {
+	/// Byte offset of the chunk in the original input
+	std::size_t offset = 0;
+	/// Chunk text (points into the original input)
+	std::string_view text;
+	/// Whether the chunk was cut at the size limit rather than after a
+	/// sentence terminator or at the end of the input
+	bool forced = false;
+};
+
+/// Splits input into chunks at boundaries where the best path is forced.
+///
+/// Chunks end after sentence terminators (。！？), newlines, or - when a
+/// sentence grows beyond the size limit - at the last whitespace or script
+/// change before the limit. A run of terminators stays in one chunk unless
+/// that would exceed the limit. Chunks never split a UTF-8 sequence.
+class SentenceChunker {
+public:
+	explicit SentenceChunker(std::string_view input,
+							 std::size_t max_chunk_bytes = DEFAULT_MAX_CHUNK_BYTES);
+
+	/// Get the next chunk, or std::nullopt when the input is exhausted
+	[[nodiscard]] std::optional<Chunk> next();
+
+private:
+	std::string_view input_;
+	std::size_t max_chunk_bytes_;
+	std::size_t pos_ = 0;
+
+	/// Length of the sentence terminator starting at pos, or 0 if none
+	[[nodiscard]] std::size_t terminator_length(std::size_t pos) const noexcept;
+
+	/// Find a forced break in (begin, limit] for sentences above the size limit
+	[[nodiscard]] std::size_t forced_break(std::size_t begin, std::size_t limit) const noexcept;
+};
+
+}// namespace kagome::tokenizer
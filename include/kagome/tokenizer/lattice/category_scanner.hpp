@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "kagome/dict/dict.hpp"
+
+namespace kagome::tokenizer::lattice {
+
+/// Finds the end of a run of characters sharing one character category.
+///
+/// ASCII runs are classified 16 bytes at a time (32 with AVX2) using byte
+/// range compares from the dictionary's ascii_category_ranges, which are
+/// built once per dictionary; 3-byte sequences (kana, kanji) are decoded
+/// inline. Everything else, and any boundary the vector path cannot
+/// decide, falls back to scalar decoding.
+class CategoryScanner {
+public:
+	/// Scans with the tables of dictionary, which must outlive the scanner
+	explicit CategoryScanner(const dict::Dict &dictionary) noexcept
+		: dict_(&dictionary)
+	{
+	}
+
+	/// Advance byte_pos over at most max_chars following characters whose
+	/// category is `category`. Stops before invalid UTF-8; returns the
+	/// number of characters consumed.
+	std::int32_t scan(std::string_view input, std::int32_t &byte_pos,
+					  dict::CharacterCategory category, std::int32_t max_chars) const;
+
+private:
+	const dict::Dict *dict_;
+
+	/// Length of the prefix of [data, data + len) consisting of ASCII bytes
+	/// in the given ranges
+	[[nodiscard]] static std::size_t ascii_run_length(const dict::AsciiCategoryRanges &set,
+													  const char *data, std::size_t len) noexcept;
+};
+
+}// namespace kagome::tokenizer::lattice
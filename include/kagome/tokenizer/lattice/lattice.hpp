@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -8,10 +9,14 @@
 #include <cstdint>
 
 #include "kagome/tokenizer/lattice/node.hpp"
+#include "kagome/tokenizer/lattice/category_scanner.hpp"
 #include "kagome/dict/dict.hpp"
 
 namespace kagome::tokenizer::lattice {
 
+/// Node ID of unknown words whose character category has no unknown dictionary entry
+constexpr std::int32_t UNMAPPED_UNKNOWN_ID = -2;
+
 /// Tokenization modes for lattice processing
 enum class LatticeMode : std::uint8_t {
 	Normal = 1,
@@ -81,8 +86,22 @@ public:
 	Lattice(Lattice &&) = default;
 	Lattice &operator=(Lattice &&) = default;
 
-	/// Build lattice from input text
-	void build(std::string_view input);
+	/// Build lattice from input text. Search mode penalties are computed
+	/// per node here when mode is not Normal. The input is not copied: node
+	/// surfaces view it, so it must outlive any use of the output.
+	void build(std::string_view input, LatticeMode mode);
+
+	/// Segment input by character category runs only, without dictionary
+	/// lookups or a full Viterbi search; output() is filled directly. Each
+	/// run becomes the unknown word build() would produce for it, with the
+	/// cheapest of its category's alternatives as forward() would pick.
+	void build_plain(std::string_view input, LatticeMode mode);
+
+	/// build_plain() for spans the dictionary is not expected to match
+	/// (e.g. ASCII). Returns false without filling output() if the
+	/// dictionary has an entry where build() would look one up; the span
+	/// then needs build() and the Viterbi search.
+	[[nodiscard]] bool try_build_plain(std::string_view input, LatticeMode mode);
 
 	/// Run forward algorithm (Viterbi)
 	void forward(LatticeMode mode);
@@ -90,6 +109,44 @@ public:
 	/// Run backward algorithm to extract best path
 	void backward(LatticeMode mode);
 
+	/// Forward algorithm specialized for one mode; mode-specific work is
+	/// compiled out of the other instantiations
+	template<LatticeMode Mode>
+	void forward();
+
+	/// Backward algorithm specialized for one mode
+	template<LatticeMode Mode>
+	void backward();
+
+	/// Limit the forward pass to the beam_width cheapest nodes ending at each
+	/// position (0 = consider all of them). Faster on long inputs with many
+	/// candidates, at the price of possibly missing the best path.
+	void set_beam_width(std::size_t beam_width) noexcept
+	{
+		beam_width_ = beam_width;
+	}
+
+	/// Limit the work of build() and forward() from now on: at most
+	/// max_edges connection cost evaluations in total (0 = unlimited) and
+	/// none after deadline. Once either is exceeded, build() and forward()
+	/// stop early, budget_exceeded() is set until the next set_budget(),
+	/// and the caller is expected to fall back to build_plain().
+	void set_budget(std::size_t max_edges,
+					std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) noexcept
+	{
+		max_edges_ = max_edges;
+		deadline_ = deadline;
+		edges_ = 0;
+		next_clock_check_ = 0;
+		budget_exceeded_ = false;
+	}
+
+	/// Whether the budget of set_budget() has been exceeded
+	[[nodiscard]] bool budget_exceeded() const noexcept
+	{
+		return budget_exceeded_;
+	}
+
 	/// Export lattice as DOT graph for visualization
 	void export_dot(std::ostream &output) const;
 
@@ -100,7 +157,7 @@ public:
 	}
 
 	/// Get input text
-	[[nodiscard]] const std::string &input() const noexcept
+	[[nodiscard]] std::string_view input() const noexcept
 	{
 		return input_;
 	}
@@ -115,8 +172,8 @@ private:
 	std::shared_ptr<dict::Dict> dict_;
 	std::shared_ptr<dict::UserDict> user_dict_;
 
-	/// Input text
-	std::string input_;
+	/// Input text, owned by the caller of build()
+	std::string_view input_;
 
 	/// Lattice nodes organized by position
 	std::vector<std::vector<Node *>> node_list_;
@@ -124,15 +181,61 @@ private:
 	/// Best path output
 	std::vector<Node *> output_;
 
-	/// Node memory pool
-	static ObjectPool<Node> node_pool_;
+	/// Same-category run finder for unknown word grouping, on the tables
+	/// dict_ shares with every other lattice
+	CategoryScanner scanner_;
+
+	/// Whether nodes get search mode penalties (set by build)
+	bool search_penalties_ = false;
+
+	/// Predecessors kept per position by forward() (0 = all)
+	std::size_t beam_width_ = 0;
+
+	/// Work budget, see set_budget()
+	std::size_t max_edges_ = 0;
+	std::chrono::steady_clock::time_point deadline_ = std::chrono::steady_clock::time_point::max();
+	std::size_t edges_ = 0;
+	std::size_t next_clock_check_ = 0;
+	bool budget_exceeded_ = false;
 
-	/// Add a node to the lattice
+	/// Edges evaluated between two deadline checks of forward()
+	static constexpr std::size_t CLOCK_CHECK_EDGES = 4096;
+	/// Characters processed between two deadline checks of build()
+	static constexpr std::int32_t CLOCK_CHECK_CHARS = 256;
+
+	/// Whether the deadline has passed; sets budget_exceeded_ if so
+	bool deadline_passed() noexcept
+	{
+		if (deadline_ != std::chrono::steady_clock::time_point::max() &&
+			std::chrono::steady_clock::now() > deadline_) {
+			budget_exceeded_ = true;
+		}
+		return budget_exceeded_;
+	}
+
+	/// Node memory pool (per thread, so lattices can run concurrently)
+	static thread_local ObjectPool<Node> node_pool_;
+
+	/// Take a node from the pool and initialize it from the dictionary entry
+	Node *new_node(std::int32_t id, std::int32_t position, std::int32_t start,
+				   NodeClass node_class, std::string_view surface);
+
+	/// build_plain(), giving up on a dictionary match if check_dictionary
+	bool build_plain_impl(std::string_view input, LatticeMode mode, bool check_dictionary);
+
+	/// Add a node of char_count characters to the lattice, ending at pos + char_count
 	void add_node(std::int32_t pos, std::int32_t id, std::int32_t position,
-				  std::int32_t start, NodeClass node_class, std::string surface);
+				  std::int32_t start, NodeClass node_class, std::string_view surface,
+				  std::int32_t char_count);
+
+	/// Extend an unknown word over the following characters of the same
+	/// category. Advances byte_pos past the word; returns its length in characters.
+	std::int32_t group_unknown(std::string_view input, std::int32_t &byte_pos,
+							   dict::CharacterCategory category) const;
 
-	/// Calculate additional cost for search mode
-	[[nodiscard]] std::int32_t additional_cost(const Node *node) const;
+	/// Calculate the search mode penalty for a surface of char_count characters
+	[[nodiscard]] std::int32_t search_penalty(std::string_view surface,
+											  std::int32_t char_count) const;
 
 	/// Check if string contains only kanji characters
 	[[nodiscard]] bool is_kanji_only(std::string_view str) const;
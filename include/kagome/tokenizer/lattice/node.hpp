@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <limits>
 
@@ -47,10 +48,10 @@ public:
 	/// Construct a node with all parameters
 	Node(std::int32_t id, std::int32_t position, std::int32_t start,
 		 NodeClass node_class, std::int32_t cost, std::int16_t left_id,
-		 std::int16_t right_id, std::int16_t weight, std::string surface)
+		 std::int16_t right_id, std::int16_t weight, std::string_view surface)
 		: id_(id), position_(position), start_(start), class_(node_class),
 		  cost_(cost), left_id_(left_id), right_id_(right_id), weight_(weight),
-		  surface_(std::move(surface)), prev_(nullptr)
+		  surface_(surface), prev_(nullptr)
 	{
 	}
 
@@ -95,7 +96,7 @@ public:
 	{
 		return weight_;
 	}
-	[[nodiscard]] const std::string &surface() const noexcept
+	[[nodiscard]] std::string_view surface() const noexcept
 	{
 		return surface_;
 	}
@@ -103,6 +104,10 @@ public:
 	{
 		return prev_;
 	}
+	[[nodiscard]] std::int32_t penalty() const noexcept
+	{
+		return penalty_;
+	}
 
 	// Mutators
 	void set_id(std::int32_t id) noexcept
@@ -137,14 +142,18 @@ public:
 	{
 		weight_ = weight;
 	}
-	void set_surface(std::string surface)
+	void set_surface(std::string_view surface) noexcept
 	{
-		surface_ = std::move(surface);
+		surface_ = surface;
 	}
 	void set_prev(const Node *prev) noexcept
 	{
 		prev_ = prev;
 	}
+	void set_penalty(std::int32_t penalty) noexcept
+	{
+		penalty_ = penalty;
+	}
 
 	/// Reset node to default state (for object pooling)
 	void reset() noexcept
@@ -157,8 +166,9 @@ public:
 		left_id_ = 0;
 		right_id_ = 0;
 		weight_ = 0;
-		surface_.clear();
+		surface_ = {};
 		prev_ = nullptr;
+		penalty_ = 0;
 	}
 
 	/// Check if this is a BOS/EOS node
@@ -192,11 +202,14 @@ private:
 	/// Base cost/weight of this morpheme
 	std::int16_t weight_ = 0;
 
-	/// Surface string (the actual text)
-	std::string surface_;
+	/// Surface string (the actual text), a view into the lattice input
+	std::string_view surface_;
 
 	/// Previous node in the best path (for backtracking)
 	const Node *prev_ = nullptr;
+
+	/// Search mode penalty added to paths leaving this node
+	std::int32_t penalty_ = 0;
 };
 
 }// namespace kagome::tokenizer::lattice
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <ankerl/unordered_dense.h>
+
+#include "kagome/tokenizer/token.hpp"
+
+namespace kagome::tokenizer {
+
+/// Bounded cache of tokenization results keyed by a hash of the input.
+///
+/// Mail campaigns repeat identical bodies many times, so a hit skips
+/// analysis entirely. Entries keep the input for verification plus one
+/// compact record per token; memory is capped and entries are evicted with
+/// the CLOCK algorithm. All members are safe to call from many threads.
+/// Results depend on the tokenizer and mode: a cache must only be used with
+/// one tokenizer, and callers mixing modes tell them apart by the tag.
+class ResultCache {
+public:
+	/// Compact form of one token; the surface is input[start, end)
+	struct CachedToken {
+		std::int32_t id = 0;
+		std::int32_t start = 0;
+		std::int32_t end = 0;
+		TokenClass token_class = TokenClass::Dummy;
+	};
+
+	/// Counters since construction (entries and bytes are current values)
+	struct Stats {
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+		std::uint64_t insertions = 0;
+		std::uint64_t evictions = 0;
+		std::size_t entries = 0;
+		std::size_t bytes = 0;
+	};
+
+	/// Create a cache holding at most about max_bytes of entries
+	explicit ResultCache(std::size_t max_bytes);
+
+	ResultCache(const ResultCache &) = delete;
+	ResultCache &operator=(const ResultCache &) = delete;
+
+	/// Look up the tokens stored for input under tag. On a hit, tokens is
+	/// replaced by views whose surfaces point into input and which resolve
+	/// features through dict and user_dict, and degraded (if given)
+	/// receives the flag the tokens were stored with.
+	[[nodiscard]] bool find(std::string_view input, const dict::Dict *dict,
+							const dict::UserDict *user_dict, std::vector<TokenView> &tokens,
+							std::uint32_t tag = 0, bool *degraded = nullptr);
+
+	/// Store the tokens of input under tag, replacing any previous entry
+	/// for them. degraded marks tokens of an analysis that ran out of
+	/// budget. Inputs too large for the cap are not stored, nor are tokens
+	/// rewritten by normalization, whose NFKC surfaces a hit could not
+	/// restore from input.
+	void insert(std::string_view input, std::span<const TokenView> tokens, std::uint32_t tag = 0,
+				bool degraded = false);
+
+	/// Drop all entries; counters are kept
+	void clear();
+
+	[[nodiscard]] Stats stats() const;
+
+	[[nodiscard]] std::size_t max_bytes() const noexcept
+	{
+		return max_bytes_;
+	}
+
+private:
+	struct Entry {
+		std::uint32_t tag = 0;
+		bool degraded = false;
+		std::string input;
+		std::vector<CachedToken> tokens;
+	};
+
+	struct Slot {
+		std::uint64_t hash = 0;
+		std::shared_ptr<const Entry> entry;
+		std::size_t bytes = 0;
+		/// Set on every hit, cleared when the clock hand passes
+		bool referenced = false;
+	};
+
+	/// Inputs larger than this fraction of the cap are never stored
+	static constexpr std::size_t MAX_ENTRY_FRACTION = 16;
+
+	const std::size_t max_bytes_;
+
+	mutable std::mutex mutex_;
+	std::vector<Slot> slots_;
+	std::vector<std::size_t> free_slots_;
+	ankerl::unordered_dense::map<std::uint64_t, std::size_t> index_;
+	std::size_t hand_ = 0;
+	Stats stats_;
+
+	/// Evict entries until bytes more fit under the cap; mutex_ must be held
+	void make_room(std::size_t bytes);
+
+	/// Remove the entry of a slot and free the slot; mutex_ must be held
+	void release(std::size_t slot);
+
+	[[nodiscard]] static std::uint64_t hash(std::string_view input, std::uint32_t tag) noexcept;
+};
+
+}// namespace kagome::tokenizer
@@ -66,6 +66,172 @@ struct TokenData {
 	std::vector<std::string> features;
 };
 
+/// Non-owning token: a byte range of the tokenized input plus the dictionary
+/// entry it maps to. The input and the dictionaries must outlive the view;
+/// TokenizeResult keeps the dictionary alive for a whole set of views.
+class TokenView {
+public:
+	TokenView() = default;
+
+	TokenView(std::int32_t index, std::int32_t id, TokenClass token_class,
+			  std::int32_t start, std::int32_t end, std::string_view surface,
+			  const dict::Dict *dict, const dict::UserDict *user_dict = nullptr) noexcept
+		: index_(index), id_(id), class_(token_class), start_(start), end_(end),
+		  surface_(surface), dict_(dict), user_dict_(user_dict)
+	{
+	}
+
+	// Accessors
+	[[nodiscard]] std::int32_t index() const noexcept
+	{
+		return index_;
+	}
+	[[nodiscard]] std::int32_t id() const noexcept
+	{
+		return id_;
+	}
+	[[nodiscard]] TokenClass token_class() const noexcept
+	{
+		return class_;
+	}
+	[[nodiscard]] std::int32_t start() const noexcept
+	{
+		return start_;
+	}
+	[[nodiscard]] std::int32_t end() const noexcept
+	{
+		return end_;
+	}
+	[[nodiscard]] std::string_view surface() const noexcept
+	{
+		return surface_;
+	}
+	[[nodiscard]] const dict::Dict *dict() const noexcept
+	{
+		return dict_;
+	}
+	[[nodiscard]] const dict::UserDict *user_dict() const noexcept
+	{
+		return user_dict_;
+	}
+
+	/// Renumber the token (used when stitching results of independent chunks)
+	void set_index(std::int32_t index) noexcept
+	{
+		index_ = index;
+	}
+
+	/// NFKC form of the surface when the tokenizer normalized the input and
+	/// this token's bytes changed, otherwise the surface. A rewritten form
+	/// views the normalized text, which lives as long as the TokenizeResult
+	/// holding the token or, for tokens passed to a callback, for the call.
+	[[nodiscard]] std::string_view normalized_surface() const noexcept
+	{
+		return normalized_surface_.data() ? normalized_surface_ : surface_;
+	}
+
+	/// Whether normalized_surface() differs from the surface
+	[[nodiscard]] bool rewritten() const noexcept
+	{
+		return normalized_surface_.data() != nullptr;
+	}
+
+	void set_normalized_surface(std::string_view normalized_surface) noexcept
+	{
+		normalized_surface_ = normalized_surface;
+	}
+
+	/// Classification flags of the dictionary entry (dict::ENTRY_FLAG_*)
+	[[nodiscard]] std::uint8_t flags() const noexcept
+	{
+		if (!dict_) {
+			return 0;
+		}
+		switch (class_) {
+		case TokenClass::Known:
+			return dict_->known_flags(id_);
+		case TokenClass::Unknown:
+			return dict_->unknown_flags(id_);
+		default:
+			return 0;
+		}
+	}
+
+	/// Get all morphological features
+	[[nodiscard]] std::vector<std::string> features() const;
+
+	/// Get feature at specific index
+	[[nodiscard]] std::optional<std::string> feature_at(std::size_t index) const;
+
+	/// Get feature at specific index without copying it. Views point into
+	/// the dictionary; joined user dictionary fields are not available.
+	[[nodiscard]] std::optional<std::string_view> feature_view(std::size_t index) const;
+
+	/// Get POS (parts of speech) tags
+	[[nodiscard]] std::vector<std::string> pos() const;
+
+	/// Get POS tags as views into the dictionary
+	[[nodiscard]] std::vector<std::string_view> pos_view() const;
+
+	/// Extract inflectional type feature
+	[[nodiscard]] std::string inflectional_type() const;
+
+	/// Extract inflectional form feature
+	[[nodiscard]] std::string inflectional_form() const;
+
+	/// Extract base form feature
+	[[nodiscard]] std::string base_form() const;
+
+	/// Extract reading (yomi) feature
+	[[nodiscard]] std::string reading() const;
+
+	/// Extract pronunciation feature
+	[[nodiscard]] std::string pronunciation() const;
+
+	/// Base form read in place ("*" when unavailable)
+	[[nodiscard]] std::string_view base_form_view() const;
+
+	/// Reading read in place ("*" when unavailable)
+	[[nodiscard]] std::string_view reading_view() const;
+
+	/// Normalized form: the base form when the entry has one, otherwise
+	/// normalized_surface(). Views dictionary, input or normalized bytes.
+	[[nodiscard]] std::string_view normalized_view() const;
+
+	/// common::hash_bytes() of normalized_view(); base form hashes of
+	/// dictionary entries are precomputed at load time
+	[[nodiscard]] std::uint64_t normalized_hash() const;
+
+	/// Pronunciation read in place ("*" when unavailable)
+	[[nodiscard]] std::string_view pronunciation_view() const;
+
+	/// Get user dictionary extra data (only for user tokens)
+	[[nodiscard]] std::optional<UserExtra> user_extra() const;
+
+	/// Convert to complete token data for serialization
+	[[nodiscard]] TokenData to_token_data() const;
+
+private:
+	std::int32_t index_ = 0;
+	std::int32_t id_ = 0;
+	TokenClass class_ = TokenClass::Dummy;
+	std::int32_t start_ = 0;
+	std::int32_t end_ = 0;
+	std::string_view surface_;
+	/// Null unless the surface was rewritten by normalization
+	std::string_view normalized_surface_;
+	const dict::Dict *dict_ = nullptr;
+	const dict::UserDict *user_dict_ = nullptr;
+
+	/// Helper to get feature by resolved dictionary column
+	[[nodiscard]] std::optional<std::string_view>
+	pickup_from_features(std::int32_t dict::FeatureColumns::*column) const;
+
+	/// Feature from the metadata column, falling back to a fixed index
+	[[nodiscard]] std::string_view feature_or_fallback(std::int32_t dict::FeatureColumns::*column,
+													   std::size_t fallback_index) const;
+};
+
 /// Main token class representing a morphological unit
 class Token {
 public:
@@ -83,6 +249,10 @@ public:
 		  std::shared_ptr<dict::Dict> dict,
 		  std::shared_ptr<dict::UserDict> user_dict = nullptr);
 
+	/// Create an owning token from a view, copying its surface
+	Token(const TokenView &view, std::shared_ptr<dict::Dict> dict,
+		  std::shared_ptr<dict::UserDict> user_dict = nullptr);
+
 	/// Copy and move constructors/assignment
 	Token(const Token &) = default;
 	Token &operator=(const Token &) = default;
@@ -121,32 +291,72 @@ public:
 		return surface_;
 	}
 
+	/// Renumber the token (used when stitching results of independent chunks)
+	void set_index(std::int32_t index) noexcept
+	{
+		index_ = index;
+	}
+
+	/// Non-owning view of this token; valid while the token is alive
+	[[nodiscard]] TokenView view() const noexcept
+	{
+		return TokenView(index_, id_, class_, start_, end_, surface_,
+						 dict_.get(), user_dict_.get());
+	}
+
 	/// Get all morphological features
-	[[nodiscard]] std::vector<std::string> features() const;
+	[[nodiscard]] std::vector<std::string> features() const
+	{
+		return view().features();
+	}
 
 	/// Get feature at specific index
-	[[nodiscard]] std::optional<std::string> feature_at(std::size_t index) const;
+	[[nodiscard]] std::optional<std::string> feature_at(std::size_t index) const
+	{
+		return view().feature_at(index);
+	}
 
 	/// Get POS (parts of speech) tags
-	[[nodiscard]] std::vector<std::string> pos() const;
+	[[nodiscard]] std::vector<std::string> pos() const
+	{
+		return view().pos();
+	}
 
 	/// Extract inflectional type feature
-	[[nodiscard]] std::string inflectional_type() const;
+	[[nodiscard]] std::string inflectional_type() const
+	{
+		return view().inflectional_type();
+	}
 
 	/// Extract inflectional form feature
-	[[nodiscard]] std::string inflectional_form() const;
+	[[nodiscard]] std::string inflectional_form() const
+	{
+		return view().inflectional_form();
+	}
 
 	/// Extract base form feature
-	[[nodiscard]] std::string base_form() const;
+	[[nodiscard]] std::string base_form() const
+	{
+		return view().base_form();
+	}
 
 	/// Extract reading (yomi) feature
-	[[nodiscard]] std::string reading() const;
+	[[nodiscard]] std::string reading() const
+	{
+		return view().reading();
+	}
 
 	/// Extract pronunciation feature
-	[[nodiscard]] std::string pronunciation() const;
+	[[nodiscard]] std::string pronunciation() const
+	{
+		return view().pronunciation();
+	}
 
 	/// Get user dictionary extra data (only for user tokens)
-	[[nodiscard]] std::optional<UserExtra> user_extra() const;
+	[[nodiscard]] std::optional<UserExtra> user_extra() const
+	{
+		return view().user_extra();
+	}
 
 	/// Check if tokens have equal features
 	[[nodiscard]] bool equal_features(const Token &other) const;
@@ -155,7 +365,10 @@ public:
 	[[nodiscard]] bool equal_pos(const Token &other) const;
 
 	/// Convert to complete token data for serialization
-	[[nodiscard]] TokenData to_token_data() const;
+	[[nodiscard]] TokenData to_token_data() const
+	{
+		return view().to_token_data();
+	}
 
 	/// String representation
 	[[nodiscard]] std::string to_string() const;
@@ -174,10 +387,74 @@ private:
 	std::string surface_;
 	std::shared_ptr<dict::Dict> dict_;
 	std::shared_ptr<dict::UserDict> user_dict_;
+};
+
+/// Tokens of one input as views. The result holds the dictionary reference
+/// once for all of its tokens; surfaces point into the tokenized input,
+/// which must outlive the result. Surfaces rewritten by normalization are
+/// kept in normalized, which the result holds too.
+class TokenizeResult {
+public:
+	TokenizeResult() = default;
+
+	TokenizeResult(std::shared_ptr<dict::Dict> dict,
+				   std::shared_ptr<dict::UserDict> user_dict,
+				   std::vector<TokenView> tokens,
+				   std::shared_ptr<const std::string> normalized = nullptr) noexcept
+		: dict_(std::move(dict)), user_dict_(std::move(user_dict)), tokens_(std::move(tokens)),
+		  normalized_(std::move(normalized))
+	{
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept
+	{
+		return tokens_.size();
+	}
+	[[nodiscard]] bool empty() const noexcept
+	{
+		return tokens_.empty();
+	}
+	[[nodiscard]] const TokenView &operator[](std::size_t i) const noexcept
+	{
+		return tokens_[i];
+	}
+	[[nodiscard]] auto begin() const noexcept
+	{
+		return tokens_.begin();
+	}
+	[[nodiscard]] auto end() const noexcept
+	{
+		return tokens_.end();
+	}
+	[[nodiscard]] const std::vector<TokenView> &tokens() const noexcept
+	{
+		return tokens_;
+	}
+
+	/// Materialize an owning token
+	[[nodiscard]] Token to_token(std::size_t i) const
+	{
+		return Token(tokens_[i], dict_, user_dict_);
+	}
+
+	/// Whether the analysis ran out of budget and split part of the input
+	/// by character class only
+	[[nodiscard]] bool degraded() const noexcept
+	{
+		return degraded_;
+	}
+
+	void set_degraded(bool degraded) noexcept
+	{
+		degraded_ = degraded;
+	}
 
-	/// Helper to get feature by dictionary key
-	[[nodiscard]] std::optional<std::string>
-	pickup_from_features(std::string_view key) const;
+private:
+	std::shared_ptr<dict::Dict> dict_;
+	std::shared_ptr<dict::UserDict> user_dict_;
+	std::vector<TokenView> tokens_;
+	std::shared_ptr<const std::string> normalized_;
+	bool degraded_ = false;
 };
 
 /// Utility functions
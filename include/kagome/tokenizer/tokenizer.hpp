@@ -1,13 +1,21 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <optional>
 #include <concepts>
+#include <functional>
 
+#include "kagome/common/thread_pool.hpp"
+#include "kagome/common/utf8.hpp"
 #include "kagome/tokenizer/token.hpp"
+#include "kagome/tokenizer/chunker.hpp"
+#include "kagome/tokenizer/result_cache.hpp"
+#include "kagome/tokenizer/lattice/lattice.hpp"
 #include "kagome/dict/dict.hpp"
 
 namespace kagome::tokenizer {
@@ -41,10 +49,38 @@ struct TokenizerConfig {
 	bool omit_bos_eos = false;
 	/// Default tokenization mode
 	TokenizeMode default_mode = TokenizeMode::Normal;
+	/// Upper bound on chunk size for streaming tokenization (0 = unlimited)
+	std::size_t max_chunk_bytes = DEFAULT_MAX_CHUNK_BYTES;
+	/// Minimum amount of input (in bytes) handed to one worker by analyze_parallel
+	std::size_t parallel_task_bytes = 64 * 1024;
+	/// Split input into ASCII and non-ASCII runs first and segment ASCII runs
+	/// by character class instead of running them through the lattice
+	bool script_prepass = false;
+	/// Keep only this many of the cheapest paths ending at each position
+	/// during the Viterbi search (0 = exact search over all of them)
+	std::size_t beam_width = 0;
+	/// Connection cost evaluations allowed per analysis call (per task for
+	/// analyze_parallel, per document for analyze_batch); 0 = unlimited
+	std::size_t max_edges = 0;
+	/// Wall-clock time allowed per analysis call, counted like max_edges;
+	/// 0 = unlimited
+	std::chrono::microseconds time_budget{0};
+	/// Analyze the NFKC form of the input, so full-width Latin, half-width
+	/// katakana and compatibility characters match the dictionary. Token
+	/// offsets and surfaces still refer to the original input; tokens from
+	/// inside one expanded character all cover that character.
+	bool normalize = false;
 };
 
-/// Forward declarations
-class Lattice;
+/// Callback receiving tokens from streaming tokenization
+using TokenCallback = std::function<void(Token &&token)>;
+
+/// Callback receiving non-owning tokens; views are valid while the input is
+using TokenViewCallback = std::function<void(const TokenView &token)>;
+
+/// Callback receiving the tokens of one document of a batch.
+/// It is invoked from worker threads, at most once concurrently per document.
+using BatchCallback = std::function<void(std::size_t document, std::vector<Token> &&tokens)>;
 
 /// Main tokenizer interface for Japanese morphological analysis
 class Tokenizer {
@@ -75,15 +111,148 @@ public:
 	/// Set the tokenization mode
 	void set_mode(TokenizerType type);
 
-	/// Tokenize input text using the default mode
-	[[nodiscard]] std::vector<Token> tokenize(std::string_view input) const;
+	/// Get the tokenizer configuration
+	[[nodiscard]] const TokenizerConfig &config() const noexcept
+	{
+		return config_;
+	}
+
+	/// Use a user dictionary (nullptr removes it). Its entries take part in
+	/// every later analysis; the script prepass is skipped while one is set
+	/// so entries spanning ASCII text are not missed.
+	void set_user_dict(std::shared_ptr<dict::UserDict> user_dictionary);
+
+	/// Get the user dictionary, if any
+	[[nodiscard]] const std::shared_ptr<dict::UserDict> &user_dict() const noexcept
+	{
+		return user_dict_;
+	}
+
+	/// Share token lists of recurring sentences (footers, disclaimers,
+	/// signatures) through cache; nullptr disables it. Sentence-chunked
+	/// analysis then runs only novel chunks through the lattice and splices
+	/// cached ones in at their offset. While a cache is set, documents are
+	/// always analyzed sentence by sentence, so the runs passed to
+	/// analyze_view() are not used; sentences longer than max_chunk_bytes
+	/// are analyzed whole rather than cut. The cache may be shared by
+	/// tokenizers with identical dictionaries and configuration.
+	void set_chunk_cache(std::shared_ptr<ResultCache> cache);
+
+	/// Get the chunk cache, if any
+	[[nodiscard]] const std::shared_ptr<ResultCache> &chunk_cache() const noexcept
+	{
+		return chunk_cache_;
+	}
+
+	/// Tokenize input text using the default mode, as analyze() does
+	[[nodiscard]] std::vector<Token> tokenize(std::string_view input, bool *degraded = nullptr) const;
+
+	/// Tokenize input text using the specified mode. If degraded is given,
+	/// it receives whether max_edges or time_budget ran out, so that part
+	/// of the input was only split by character class (see analyze_view()).
+	[[nodiscard]] std::vector<Token> analyze(std::string_view input, TokenizeMode mode,
+											 bool *degraded = nullptr) const;
+
+	/// Tokenize input into non-owning token views. Avoids a dictionary
+	/// reference and a surface copy per token; input must outlive the result.
+	/// When max_edges or time_budget runs out, the rest of the input is split
+	/// by character class only and the result is marked degraded().
+	[[nodiscard]] TokenizeResult analyze_view(std::string_view input, TokenizeMode mode) const;
 
-	/// Tokenize input text using the specified mode
-	[[nodiscard]] std::vector<Token> analyze(std::string_view input, TokenizeMode mode) const;
+	/// Like analyze_view(), but the script prepass uses runs computed by the
+	/// caller (e.g. during language detection) instead of scanning input
+	/// again. runs must split input into consecutive ASCII and non-ASCII
+	/// runs; they are ignored when the prepass is disabled.
+	[[nodiscard]] TokenizeResult analyze_view(std::string_view input, TokenizeMode mode,
+											  std::span<const common::ByteRun> runs) const;
+
+	/// Like analyze_view(input, mode, runs), but reuses a lattice from
+	/// create_lattice() instead of creating one per call. The tokenizer may
+	/// be shared between threads; a lattice must only be used by one at a time.
+	[[nodiscard]] TokenizeResult analyze_view(lattice::Lattice &lattice, std::string_view input,
+											  TokenizeMode mode,
+											  std::span<const common::ByteRun> runs = {}) const;
+
+	/// Walk the best path of input in order and call visitor(const TokenView &)
+	/// for each token, without collecting them: views carry the entry id,
+	/// class, byte range and precomputed entry flags, as in analyze_view().
+	/// runs are used as in analyze_view(); lattice.budget_exceeded() tells
+	/// afterwards whether the analysis was degraded.
+	template<typename Visitor>
+	void visit(lattice::Lattice &lattice, std::string_view input, TokenizeMode mode,
+			   Visitor &&visitor, std::span<const common::ByteRun> runs = {}) const
+	{
+		if (!get_dict() || chunk_cache_ || config_.normalize) {
+			// Cached and normalized tokens go through type-erased callbacks.
+			// A reference wrapper fits the callback's inline storage, so
+			// wrapping the visitor allocates nothing.
+			visit_impl(lattice, input, mode, runs, TokenViewCallback(std::ref(visitor)));
+			return;
+		}
+
+		// Otherwise tokens come straight from the best path, and the visitor
+		// is called directly so that it can be inlined into the loop
+		std::int32_t index = 0;
+		start_budget(lattice);
+
+		if (!use_script_prepass() || runs.empty()) {
+			// An empty input has no runs but still gets BOS/EOS
+			analyze_segment(lattice, input, 0, mode, index, true, true, visitor);
+			return;
+		}
+
+		for (std::size_t i = 0; i < runs.size(); ++i) {
+			const auto &run = runs[i];
+			analyze_run(lattice, input.substr(run.offset, run.length), run.ascii,
+						static_cast<std::int32_t>(run.offset), mode, index,
+						i == 0, i + 1 == runs.size(), visitor);
+		}
+	}
+
+	/// Create a lattice over the tokenizer's dictionaries, e.g. to keep one
+	/// per thread for analyze_view()
+	[[nodiscard]] std::unique_ptr<lattice::Lattice> create_lattice() const;
+
+	/// Tokenize input chunk by chunk, passing each token to the callback.
+	/// Only one chunk is held in the lattice at a time, so memory stays bounded
+	/// by the chunk size; token offsets are relative to the whole input.
+	/// degraded, if given, is set as by analyze() once all tokens are passed.
+	void analyze_stream(std::string_view input, TokenizeMode mode,
+						const TokenCallback &callback, bool *degraded = nullptr) const;
+
+	/// Tokenize independent chunks of one document on the thread pool.
+	/// The result is identical to collecting the tokens of analyze_stream().
+	/// degraded, if given, is set when any task ran out of its budget.
+	[[nodiscard]] std::vector<Token> analyze_parallel(std::string_view input, TokenizeMode mode,
+													  common::ThreadPool &pool, bool *degraded = nullptr) const;
+
+	/// Tokenize many documents on the thread pool, passing each document's
+	/// tokens to the callback. Every worker task reuses one lattice for a
+	/// contiguous block of documents; per-document results match analyze().
+	/// degraded, if given, points to documents.size() flags, each set as by
+	/// analyze() for its document before the callback gets its tokens.
+	void analyze_batch(std::span<const std::string_view> documents, TokenizeMode mode,
+					   common::ThreadPool &pool, const BatchCallback &callback,
+					   bool *degraded = nullptr) const;
+
+	/// Tokenize many documents on the thread pool, returning results in
+	/// input order; degraded is as for the callback variant
+	[[nodiscard]] std::vector<std::vector<Token>>
+	analyze_batch(std::span<const std::string_view> documents, TokenizeMode mode,
+				  common::ThreadPool &pool, bool *degraded = nullptr) const;
 
 	/// Wakati tokenization - returns only surface strings
 	[[nodiscard]] std::vector<std::string> wakati(std::string_view input) const;
 
+	/// Wakati tokenization into views of input: surfaces is cleared and
+	/// filled with the non-empty token surfaces, without building tokens or
+	/// copying strings. Passing the same vector on every call reuses its storage.
+	void wakati(std::string_view input, std::vector<std::string_view> &surfaces) const;
+
+	/// Like wakati(input, surfaces), but reuses a lattice from create_lattice()
+	void wakati(lattice::Lattice &lattice, std::string_view input,
+				std::vector<std::string_view> &surfaces) const;
+
 	/// Export lattice graph in DOT format for debugging
 	[[nodiscard]] std::vector<Token> analyze_graph(std::ostream &dot_output,
 												   std::string_view input,
@@ -94,10 +263,161 @@ private:
 	std::shared_ptr<dict::UserDict> user_dict_;
 	std::shared_ptr<dict::Dict> shared_dict_;// For shared_ptr compatibility
 	TokenizerConfig config_;
+	std::shared_ptr<ResultCache> chunk_cache_;
 
-	/// Internal tokenization implementation
+	/// Internal tokenization implementation; degraded may be null
 	std::vector<Token> analyze_impl(std::string_view input, TokenizeMode mode,
-									std::ostream *dot_output = nullptr) const;
+									std::ostream *dot_output, bool *degraded) const;
+
+	/// Get the dictionary as a shared_ptr (non-owning when held by unique_ptr)
+	std::shared_ptr<dict::Dict> shared_dict() const;
+
+	/// Analyze input as analyze_view() does, passing tokens to callback
+	void visit_impl(lattice::Lattice &lattice, std::string_view input, TokenizeMode mode,
+					std::span<const common::ByteRun> runs, const TokenViewCallback &callback) const;
+
+	/// Start the max_edges/time_budget budget of one analysis call on lattice
+	void start_budget(lattice::Lattice &lattice) const;
+
+	/// Whether the script prepass applies to this tokenizer
+	[[nodiscard]] bool use_script_prepass() const noexcept
+	{
+		return config_.script_prepass && !user_dict_;
+	}
+
+	/// Build the lattice for input and extract the best path
+	void run_lattice(lattice::Lattice &lattice, std::string_view input,
+					 TokenizeMode mode) const;
+
+	/// Tokenize a whole document, chunk by chunk through the chunk cache
+	/// when one is set
+	void analyze_document(lattice::Lattice &lattice, std::string_view input,
+						  TokenizeMode mode, std::int32_t &index,
+						  const TokenViewCallback &callback) const;
+
+	/// Call analyze with the NFKC form of input when normalization is
+	/// enabled and changes it, and a callback mapping its tokens back to
+	/// input; otherwise with input and callback as they are. The NFKC form
+	/// is built per call, not kept per tokenizer: rewritten tokens view it
+	/// until callback returns, and a callback may tokenize again.
+	void analyze_normalized(std::string_view input, const TokenViewCallback &callback,
+							const std::function<void(std::string_view, const TokenViewCallback &)> &analyze) const;
+
+	/// Tokenize input split into sentence chunks, with BOS/EOS only at its ends
+	void analyze_chunks(lattice::Lattice &lattice, std::string_view input,
+						TokenizeMode mode, std::int32_t &index,
+						const TokenViewCallback &callback) const;
+
+	/// Tokenize input sentence by sentence through the chunk cache, with
+	/// BOS/EOS only at its ends. Unlike analyze_chunks(), input is only
+	/// split after sentence terminators: a sentence above the chunk size
+	/// limit is analyzed in one piece, so the tokens are those of
+	/// analyze_segment() on the sentence.
+	void analyze_sentences(lattice::Lattice &lattice, std::string_view input,
+						   TokenizeMode mode, std::int32_t &index,
+						   const TokenViewCallback &callback) const;
+
+	/// Like analyze_segment() on the chunk, but answers chunks seen before
+	/// from the chunk cache and stores the tokens of new ones. Chunks cut
+	/// at the size limit bypass the cache: their tokens depend on where
+	/// the cut fell.
+	void analyze_chunk(lattice::Lattice &lattice, const Chunk &chunk,
+					   TokenizeMode mode, std::int32_t &index,
+					   bool keep_bos, bool keep_eos,
+					   const TokenViewCallback &callback) const;
+
+	/// Emit a BOS/EOS token at position, or only count it when omitted
+	void emit_boundary(std::int32_t position, std::int32_t &index,
+					   const TokenViewCallback &callback) const;
+
+	/// Tokenize one segment of the input (starting offset bytes into it) and
+	/// emit its tokens; applies the script prepass when it is enabled
+	template<typename Callback>
+	void analyze_segment(lattice::Lattice &lattice,
+						 std::string_view text, std::int32_t offset,
+						 TokenizeMode mode, std::int32_t &index,
+						 bool keep_bos, bool keep_eos,
+						 Callback &&callback) const
+	{
+		if (!use_script_prepass()) {
+			run_lattice(lattice, text, mode);
+			emit_tokens(lattice, offset, index, keep_bos, keep_eos, callback);
+			return;
+		}
+
+		// Alternate between ASCII and non-ASCII runs; only the latter can match
+		// Japanese dictionary entries and need the lattice
+		std::size_t pos = 0;
+		do {
+			const char *data = text.data() + pos;
+			const std::size_t remaining = text.size() - pos;
+			const bool ascii = remaining == 0 || static_cast<unsigned char>(*data) < 0x80;
+			const std::size_t length = ascii ? common::ascii_prefix_length(data, remaining)
+											 : common::non_ascii_prefix_length(data, remaining);
+
+			analyze_run(lattice, text.substr(pos, length), ascii, offset + static_cast<std::int32_t>(pos),
+						mode, index, keep_bos && pos == 0, keep_eos && pos + length == text.size(), callback);
+			pos += length;
+		} while (pos < text.size());
+	}
+
+	/// Tokenize one ASCII or non-ASCII run of the prepass and emit its tokens
+	template<typename Callback>
+	void analyze_run(lattice::Lattice &lattice, std::string_view run, bool ascii,
+					 std::int32_t offset, TokenizeMode mode, std::int32_t &index,
+					 bool keep_bos, bool keep_eos,
+					 Callback &&callback) const
+	{
+		// ASCII runs the dictionary has entries for still need the lattice
+		if (!ascii || !lattice.try_build_plain(run, static_cast<lattice::LatticeMode>(mode))) {
+			run_lattice(lattice, run, mode);
+		}
+
+		emit_tokens(lattice, offset, index, keep_bos, keep_eos, callback);
+	}
+
+	/// Convert the lattice best path to token views shifted by offset bytes;
+	/// surfaces point into the text the lattice was built over.
+	/// BOS/EOS are only kept when keep_bos/keep_eos are set and the config allows it.
+	template<typename Callback>
+	void emit_tokens(const lattice::Lattice &lattice, std::int32_t offset, std::int32_t &index,
+					 bool keep_bos, bool keep_eos,
+					 Callback &&callback) const
+	{
+		const auto &output = lattice.output();
+		const dict::Dict *dict = get_dict();
+
+		for (std::size_t i = 0; i < output.size(); ++i) {
+			const auto *node = output[i];
+			if (node->is_bos_eos()) {
+				// BOS/EOS of inner chunks are an artifact of chunking - drop them entirely
+				bool is_bos = (i == 0);
+				if ((is_bos && !keep_bos) || (!is_bos && !keep_eos)) {
+					continue;
+				}
+				if (config_.omit_bos_eos) {
+					++index;
+					continue;
+				}
+			}
+
+			// Node surfaces already view the caller's text at their byte position
+			std::string_view surface = node->surface();
+			std::int32_t position = offset + node->position();
+			std::int32_t end_pos = position + static_cast<std::int32_t>(surface.length());
+
+			callback(TokenView(
+				index++,                                    // index
+				node->id(),                                 // id
+				static_cast<TokenClass>(node->node_class()),// token_class
+				position,                                   // start
+				end_pos,                                    // end
+				surface,                                    // surface
+				dict,                                       // dict
+				user_dict_.get()                            // user_dict
+				));
+		}
+	}
 
 	/// Get the dictionary pointer (works with both unique_ptr and shared_ptr constructors)
 	dict::Dict *get_dict() const
@@ -1,24 +1,57 @@
 #include "kagome/c_api/kagome_c_api.h"
+#include "kagome/c_api/options.hpp"
 #include "kagome/tokenizer/tokenizer.hpp"
 #include "kagome/tokenizer/token.hpp"
+#include "kagome/tokenizer/lattice/lattice.hpp"
+#include "kagome/tokenizer/result_cache.hpp"
 #include "kagome/dict/dict.hpp"
+#include "kagome/common/script.hpp"
+#include "kagome/common/hash.hpp"
+#include "kagome/common/utf8.hpp"
 
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <functional>
+#include <cassert>
 #include <cctype>
+#include <cstddef>
 #include <cstring>
 #include <iostream>
 #include <filesystem>
 #include <dlfcn.h>
 #include <unicode/utf8.h>
 #include <unicode/ustring.h>
-#include <unicode/uscript.h>
+
+struct kagome_tokenizer_handle {
+	/// Tokenizer over the shared dictionary; safe to use from many threads
+	std::unique_ptr<kagome::tokenizer::Tokenizer> tokenizer;
+	/// Dictionary of the tokenizer, for views rebuilt from the cache
+	const kagome::dict::Dict *dictionary = nullptr;
+
+	/// Results of recently seen texts (null when disabled)
+	std::unique_ptr<kagome::tokenizer::ResultCache> cache;
+
+	/// Lattices not currently in use, reused across calls
+	std::mutex lattices_mutex;
+	std::vector<std::unique_ptr<kagome::tokenizer::lattice::Lattice>> idle_lattices;
+
+	/// Longest prefix of a text that is tokenized (0 = unlimited)
+	std::size_t max_input_bytes = 0;
+	/// Bytes sampled by language detection (0 = whole text)
+	std::size_t detect_max_bytes = 0;
+
+	/// Worker pool for batch tokenization, created on first use
+	std::size_t batch_threads = 0;
+	std::mutex pool_mutex;
+	std::unique_ptr<kagome::common::ThreadPool> pool;
+};
 
 namespace {
-// Global tokenizer instance
-std::unique_ptr<kagome::tokenizer::Tokenizer> g_tokenizer;
 
 // Helper function to get the directory of the current shared library
 std::string get_library_directory()
@@ -31,466 +64,1095 @@ std::string get_library_directory()
 	return "";
 }
 
-// Helper function to detect Japanese characters
-bool contains_japanese_chars(const char *text, size_t len)
+// Decode UTF-8 into out, which must hold at least utf8_str.length() code
+// points; returns the number written. Invalid sequences are dropped.
+size_t utf8_to_utf32(std::string_view utf8_str, uint32_t *out)
 {
-	const char *pos = text;
-	const char *end = text + len;
+	const char *pos = utf8_str.data();
+	const char *end = pos + utf8_str.length();
+	size_t count = 0;
 
 	while (pos < end) {
+		// ASCII, most of mail text, is widened 16 bytes at a time with SSE2
+		// (zero-extending unpacks), or 8 bytes at a time elsewhere
+#if defined(__SSE2__)
+		if (end - pos >= 16) {
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+			if (_mm_movemask_epi8(bytes) == 0) {
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+				const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+				auto *dst = reinterpret_cast<__m128i *>(out + count);
+				_mm_storeu_si128(dst, _mm_unpacklo_epi16(low, zero));
+				_mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(low, zero));
+				_mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(high, zero));
+				_mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(high, zero));
+				pos += 16;
+				count += 16;
+				continue;
+			}
+		}
+#endif
+		if (end - pos >= 8) {
+			uint64_t chunk;
+			std::memcpy(&chunk, pos, sizeof(chunk));
+			if ((chunk & 0x8080808080808080ull) == 0) {
+				for (int i = 0; i < 8; ++i) {
+					out[count + i] = static_cast<unsigned char>(pos[i]);
+				}
+				pos += 8;
+				count += 8;
+				continue;
+			}
+		}
+		if (static_cast<unsigned char>(*pos) < 0x80) {
+			out[count++] = static_cast<unsigned char>(*pos++);
+			continue;
+		}
+
 		UChar32 ch;
 		int32_t offset = 0;
 		U8_NEXT(pos, offset, end - pos, ch);
 		if (offset <= 0) break;
 		pos += offset;
+		if (ch >= 0) {
+			out[count++] = static_cast<uint32_t>(ch);
+		}
+	}
+	return count;
+}
 
-		// Check for Hiragana, Katakana, or Kanji scripts
-		UErrorCode error = U_ZERO_ERROR;
-		UScriptCode script = uscript_getScript(ch, &error);
-		if (U_SUCCESS(error)) {
-			if (script == USCRIPT_HIRAGANA ||
-				script == USCRIPT_KATAKANA ||
-				script == USCRIPT_HAN) {
-				return true;
-			}
+// Every buffer of one result lives in a single block: this header, the
+// rspamd_word_t array (result->a points right past the header) growing
+// from the front and the UTF-32 storage and normalized forms of all words
+// growing from the back. Freed blocks are kept per thread and reused.
+// The array is not a kvec allocation of its own, so results leave m at 0
+// and cleanup checks the header before releasing anything.
+struct alignas(std::max_align_t) ResultArena {
+	size_t capacity;// Usable bytes after the header
+	size_t count;// Elements of the array handed out, the result's n
+	uint32_t magic;// ARENA_MAGIC while handed out
+	unsigned int flags;// ARENA_FLAG_*
+};
+
+// Marks an arena behind a live result
+constexpr uint32_t ARENA_MAGIC = 0x4b414d52;
+
+// The analysis ran out of its edge or time budget
+constexpr unsigned int ARENA_FLAG_DEGRADED = 1u << 0u;
+
+// Larger blocks go back to the allocator instead of being kept around
+constexpr size_t MAX_SPARE_ARENA_BYTES = 4 * 1024 * 1024;
+
+// First block of a result when no spare one is at hand; blocks double
+// from there as the result grows
+constexpr size_t INITIAL_ARENA_BYTES = 16 * 1024;
+
+struct SpareArena {
+	ResultArena *arena = nullptr;
+
+	~SpareArena()
+	{
+		free(arena);
+	}
+};
+
+thread_local SpareArena t_spare_arena;
+
+ResultArena *acquire_arena(size_t bytes)
+{
+	// Capacities stay multiples of the header alignment, so storage taken
+	// from the back of a block is as aligned as storage from the front
+	bytes = (bytes + alignof(ResultArena) - 1) & ~(alignof(ResultArena) - 1);
+
+	ResultArena *arena = t_spare_arena.arena;
+	if (arena && arena->capacity >= bytes) {
+		t_spare_arena.arena = nullptr;
+	}
+	else {
+		arena = static_cast<ResultArena *>(malloc(sizeof(ResultArena) + bytes));
+		if (!arena) {
+			return nullptr;
 		}
+		arena->capacity = bytes;
 	}
-	return false;
+
+	arena->count = 0;
+	arena->magic = ARENA_MAGIC;
+	arena->flags = 0;
+	return arena;
 }
 
-// Helper function to allocate C strings safely
-char *strdup_safe(const std::string &str)
+void release_arena(ResultArena *arena)
 {
-	if (str.empty()) {
-		char *result = static_cast<char *>(malloc(1));
-		if (result) result[0] = '\0';
-		return result;
+	arena->magic = 0;
+
+	ResultArena *&spare = t_spare_arena.arena;
+	if (arena->capacity > MAX_SPARE_ARENA_BYTES) {
+		free(arena);
+		return;
 	}
 
-	char *result = static_cast<char *>(malloc(str.length() + 1));
-	if (result) {
-		std::memcpy(result, str.c_str(), str.length() + 1);
+	// Keep whichever block is larger
+	if (spare && spare->capacity >= arena->capacity) {
+		free(arena);
+		return;
 	}
-	return result;
+	free(spare);
+	spare = arena;
 }
 
-// Helper function to convert UTF-8 to UTF-32
-std::vector<uint32_t> utf8_to_utf32(const std::string &utf8_str)
+// A block of at least bytes holding the first head and the last tail bytes
+// of arena at its front and back, or null. arena is left to the caller,
+// which rebases its pointers before releasing it.
+ResultArena *grow_arena(const ResultArena *arena, size_t head, size_t tail, size_t bytes)
 {
-	std::vector<uint32_t> result;
-	const char *pos = utf8_str.c_str();
-	const char *end = pos + utf8_str.length();
-
-	while (pos < end) {
-		UChar32 ch;
-		int32_t offset = 0;
-		U8_NEXT(pos, offset, end - pos, ch);
-		if (offset <= 0) break;
-		pos += offset;
-		if (ch >= 0) {
-			result.push_back(static_cast<uint32_t>(ch));
-		}
+	ResultArena *grown = acquire_arena(bytes);
+	if (!grown) {
+		return nullptr;
 	}
-	return result;
+
+	const auto *from = reinterpret_cast<const char *>(arena + 1);
+	auto *to = reinterpret_cast<char *>(grown + 1);
+	std::memcpy(to, from, head);
+	std::memcpy(to + grown->capacity - tail, from + arena->capacity - tail, tail);
+	return grown;
 }
-}// namespace
 
-extern "C" {
+// The arena behind a result array, or null if the result is not as
+// finish() left it (grown, resized or released already)
+template<typename Result>
+ResultArena *arena_of(const Result &result)
+{
+	auto *arena = reinterpret_cast<ResultArena *>(result.a) - 1;
+	if (result.m != 0 || arena->magic != ARENA_MAGIC || arena->count != result.n) {
+		return nullptr;
+	}
+	return arena;
+}
 
-int kagome_init(const ucl_object_t * /* config */, char *error_buf, size_t error_buf_size)
+// Rspamd flags of a token
+unsigned int word_flags(const kagome::tokenizer::TokenView &token)
 {
-	try {
-		// For now, ignore config and use default IPA dictionary
-		// TODO: In future, rspamd can pass preprocessed config as environment variables
-		// or through a different mechanism
-		kagome::tokenizer::DictType dict_type = kagome::tokenizer::DictType::IPA;
+	unsigned int flags = RSPAMD_WORD_FLAG_TEXT | RSPAMD_WORD_FLAG_UTF | RSPAMD_WORD_FLAG_NORMALISED;
 
-		std::unique_ptr<kagome::dict::Dict> dictionary;
+	// Japanese Part-of-Speech filtering and classification, precomputed
+	// per dictionary entry from POS rules at load time
+	const std::uint8_t entry_flags = token.flags();
 
-		// Search for dictionary in various locations
-		{
-			// Fallback to searching common paths
-			std::vector<std::string> potential_paths;
-
-			// Get library directory for relative paths
-			std::string lib_dir = get_library_directory();
-
-			if (dict_type == kagome::tokenizer::DictType::IPA) {
-				potential_paths = {
-					"data/ipa/ipa.dict",
-					"../data/ipa/ipa.dict",
-					"../../data/ipa/ipa.dict",
-					"/usr/local/share/kagome/ipa.dict",
-					"/usr/share/kagome/ipa.dict",
-					"/opt/kagome/ipa.dict"};
-
-				// Add library-relative paths
-				if (!lib_dir.empty()) {
-					potential_paths.insert(potential_paths.begin(), {lib_dir + "/ipa.dict",
-																	 lib_dir + "/data/ipa/ipa.dict"});
+	// 記号 = symbols/punctuation (。、！？etc.)
+	// These should be marked as exceptions to skip them in statistical analysis
+	if (entry_flags & kagome::dict::ENTRY_FLAG_PUNCTUATION) {
+		flags |= RSPAMD_WORD_FLAG_EXCEPTION;
+	}
+	// 助詞/助動詞 = particles and auxiliary verbs - grammatical function,
+	// less semantic weight; these are stop words
+	else if (entry_flags & kagome::dict::ENTRY_FLAG_STOP_WORD) {
+		flags |= RSPAMD_WORD_FLAG_STOP_WORD;
+	}
+	// TODO: Consider also marking very common words like それ、これ、あれ as stop words
+
+	return flags;
+}
+
+// Builds an rspamd words result from tokens passed one at a time in text
+// order, writing each word straight into a result arena: words from the
+// front, their UTF-32 forms (and normalized forms rewritten by
+// normalization) from the back. When the two meet the arena is replaced by
+// one twice as large and the pointers into it are rebased.
+class WordsBuilder {
+public:
+	WordsBuilder(std::string_view text, rspamd_words_t *result)
+		: text_(text), result_(result)
+	{
+	}
+
+	~WordsBuilder()
+	{
+		// Not handed out by finish(), as when the analysis threw
+		if (arena_) {
+			release_arena(arena_);
+		}
+	}
+
+	WordsBuilder(const WordsBuilder &) = delete;
+	WordsBuilder &operator=(const WordsBuilder &) = delete;
+
+	void add(const kagome::tokenizer::TokenView &token)
+	{
+		// Skip empty tokens (BOS/EOS markers)
+		const size_t len = token.surface().length();
+		if (len == 0 || failed_) {
+			return;
+		}
+
+		// Token offsets are exact byte offsets into text, so surfaces map
+		// back to the input without searching
+		const auto pos = static_cast<size_t>(token.start());
+		assert(token.start() >= 0 && pos + len <= text_.size());
+		assert(std::memcmp(text_.data() + pos, token.surface().data(), len) == 0);
+		std::string_view surface = text_.substr(pos, len);
+
+		const unsigned int flags = word_flags(token);
+		// Punctuation gets no unicode field, as rspamd skips it anyway. A
+		// word never has more code points than bytes.
+		const bool decode = (flags & RSPAMD_WORD_FLAG_EXCEPTION) == 0;
+
+		// Base form from the dictionary's interned pool if the entry has
+		// one, otherwise the surface; either way the bytes outlive the
+		// result, so nothing is copied. Only a surface rewritten by
+		// normalization is copied, into the arena.
+		std::string_view normalized_source = token.normalized_view();
+		bool copy_normalized = false;
+		if (normalized_source.data() == token.surface().data()) {
+			normalized_source = surface;
+		}
+		else if (token.rewritten() && normalized_source.data() == token.normalized_surface().data()) {
+			copy_normalized = true;
+		}
+		const size_t normalized_bytes = copy_normalized ? align_tail(normalized_source.size()) : 0;
+
+		if (!reserve((decode ? len * sizeof(uint32_t) : 0) + normalized_bytes)) {
+			failed_ = true;
+			return;
+		}
+
+		rspamd_word_t &word = words()[count_++];
+		word = rspamd_word_t{};
+
+		// CRITICAL: Always point to original text buffer
+		word.original.begin = surface.data();
+		word.original.len = surface.length();
+		word.flags = flags;
+
+		if (copy_normalized) {
+			tail_ += normalized_bytes;
+			char *copy = end() - tail_;
+			std::memcpy(copy, normalized_source.data(), normalized_source.size());
+			normalized_source = std::string_view(copy, normalized_source.size());
+		}
+
+		// Normalized and stemmed forms borrow dictionary or input bytes (or
+		// the arena, see above), are never freed by kagome_cleanup_result
+		// and carry no terminator
+		word.normalized.begin = normalized_source.data();
+		word.normalized.len = normalized_source.length();
+
+		// For Japanese, stemmed form is the same as normalized (no further stemming needed)
+		word.stemmed = word.normalized;
+
+		// Only words rspamd looks at get a unicode field, and each surface
+		// is decoded on its own rather than slicing one pass over the whole
+		// message: the bytes decoded are the same, minus punctuation and
+		// anything no word covers, every slice starts on a code point even
+		// after invalid bytes, and the result needs no UTF-32 copy of the
+		// whole message before the words are known. The code points are
+		// decoded below the used tail and moved up against it when fewer
+		// than len; a word without any keeps a null begin.
+		if (decode) {
+			auto *top = reinterpret_cast<uint32_t *>(end() - tail_);
+			uint32_t *slot = top - len;
+			const size_t utf32_len = utf8_to_utf32(surface, slot);
+			if (utf32_len != 0) {
+				if (utf32_len < len) {
+					std::memmove(top - utf32_len, slot, utf32_len * sizeof(uint32_t));
 				}
+				word.unicode.begin = top - utf32_len;
+				word.unicode.len = utf32_len;
+				tail_ += align_tail(utf32_len * sizeof(uint32_t));
 			}
-			else if (dict_type == kagome::tokenizer::DictType::UniDic) {
-				potential_paths = {
-					"data/uni/uni.dict",
-					"../data/uni/uni.dict",
-					"../../data/uni/uni.dict",
-					"/usr/local/share/kagome/uni.dict",
-					"/usr/share/kagome/uni.dict",
-					"/opt/kagome/uni.dict"};
-
-				// Add library-relative paths
-				if (!lib_dir.empty()) {
-					potential_paths.insert(potential_paths.begin(), {lib_dir + "/uni.dict",
-																	 lib_dir + "/data/uni/uni.dict"});
-				}
+		}
+	}
+
+	// Hand the written words over to result; degraded marks a result cut
+	// short by the analysis budget
+	int finish(bool degraded)
+	{
+		result_->a = nullptr;
+		result_->n = 0;
+		result_->m = 0;
+
+		if (failed_) {
+			return -1;
+		}
+		if (count_ == 0) {
+			return 0;
+		}
+
+		if (degraded) {
+			arena_->flags |= ARENA_FLAG_DEGRADED;
+		}
+		arena_->count = count_;
+		result_->a = words();
+		result_->n = count_;
+		arena_ = nullptr;
+		return 0;
+	}
+
+private:
+	std::string_view text_;
+	rspamd_words_t *result_;
+	ResultArena *arena_ = nullptr;
+	size_t count_ = 0;
+	// Bytes used at the back of the arena
+	size_t tail_ = 0;
+	bool failed_ = false;
+
+	// Storage at the back is taken in whole code units, so UTF-32 slices
+	// stay aligned after normalized forms of any length
+	static size_t align_tail(size_t bytes) noexcept
+	{
+		return (bytes + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+	}
+
+	rspamd_word_t *words() const noexcept
+	{
+		return reinterpret_cast<rspamd_word_t *>(arena_ + 1);
+	}
+
+	char *end() const noexcept
+	{
+		return reinterpret_cast<char *>(arena_ + 1) + arena_->capacity;
+	}
+
+	// Make room for one more word and tail more bytes at the back
+	bool reserve(size_t tail)
+	{
+		const size_t needed = (count_ + 1) * sizeof(rspamd_word_t) + tail_ + tail;
+		if (!arena_) {
+			arena_ = acquire_arena(std::max(needed, INITIAL_ARENA_BYTES));
+			return arena_ != nullptr;
+		}
+		if (needed <= arena_->capacity) {
+			return true;
+		}
+
+		ResultArena *grown =
+			grow_arena(arena_, count_ * sizeof(rspamd_word_t), tail_, std::max(needed, arena_->capacity * 2));
+		if (!grown) {
+			return false;
+		}
+
+		// Pointers into the back keep their distance from the end
+		const char *old_tail = end() - tail_;
+		const char *old_end = end();
+		char *new_end = reinterpret_cast<char *>(grown + 1) + grown->capacity;
+		auto rebase = [&](const char *p) { return new_end - (old_end - p); };
+		auto *moved = reinterpret_cast<rspamd_word_t *>(grown + 1);
+		for (size_t i = 0; i < count_; ++i) {
+			auto &word = moved[i];
+			if (word.unicode.len != 0) {
+				word.unicode.begin = reinterpret_cast<const uint32_t *>(
+					rebase(reinterpret_cast<const char *>(word.unicode.begin)));
+			}
+			if (!std::less<const char *>{}(word.normalized.begin, old_tail) &&
+				std::less<const char *>{}(word.normalized.begin, old_end)) {
+				word.normalized.begin = rebase(word.normalized.begin);
+				word.stemmed.begin = word.normalized.begin;
 			}
+		}
 
-			// Try to load from paths with better error handling
-			std::string last_error;
-			for (const auto &path: potential_paths) {
-				if (std::filesystem::exists(path)) {
-					try {
-						// Add extra safety check for file size
-						auto file_size = std::filesystem::file_size(path);
-						if (file_size == 0 || file_size > 500 * 1024 * 1024) {// Max 500MB
-							last_error = "Dictionary file size invalid: " + std::to_string(file_size);
-							continue;
-						}
+		release_arena(arena_);
+		arena_ = grown;
+		return true;
+	}
+};
 
-						dictionary = kagome::dict::DictLoader::load_from_zip(path, true);
-						if (dictionary) {
-							break;
-						}
-					} catch (const std::exception &e) {
-						last_error = std::string("Failed to load ") + path + ": " + e.what();
-						// Continue trying other paths
-						continue;
-					} catch (...) {
-						last_error = std::string("Unknown error loading ") + path;
-						continue;
-					}
-				}
+// Load the configured dictionary, or search the usual locations for one
+// and fall back to the built-in minimal dictionary. Returns nullptr with
+// error_buf filled when nothing could be loaded.
+std::unique_ptr<kagome::dict::Dict> load_dictionary(const kagome::c_api::Options &options,
+													char *error_buf, size_t error_buf_size)
+{
+	kagome::tokenizer::DictType dict_type = options.dictionary_type;
+
+	std::unique_ptr<kagome::dict::Dict> dictionary;
+
+	if (!options.dictionary.empty()) {
+		// An explicitly configured dictionary must load; no silent fallback
+		if (!std::filesystem::is_regular_file(options.dictionary)) {
+			if (error_buf && error_buf_size > 0) {
+				std::snprintf(error_buf, error_buf_size, "Dictionary not found: %s", options.dictionary.c_str());
+			}
+			return nullptr;
+		}
+		try {
+			dictionary = kagome::dict::DictLoader::load_from_zip(options.dictionary, true);
+		} catch (const std::exception &e) {
+			if (error_buf && error_buf_size > 0) {
+				std::snprintf(error_buf, error_buf_size, "Failed to load %s: %s",
+							  options.dictionary.c_str(), e.what());
 			}
+			return nullptr;
+		}
+		if (!dictionary) {
+			if (error_buf && error_buf_size > 0) {
+				std::snprintf(error_buf, error_buf_size, "Failed to load %s", options.dictionary.c_str());
+			}
+			return nullptr;
+		}
+	}
+	else {
+		// Fallback to searching common paths
+		std::vector<std::string> potential_paths;
+
+		// Get library directory for relative paths
+		std::string lib_dir = get_library_directory();
+
+		if (dict_type == kagome::tokenizer::DictType::IPA) {
+			potential_paths = {
+				"data/ipa/ipa.dict",
+				"../data/ipa/ipa.dict",
+				"../../data/ipa/ipa.dict",
+				"/usr/local/share/kagome/ipa.dict",
+				"/usr/share/kagome/ipa.dict",
+				"/opt/kagome/ipa.dict"};
+
+			// Add library-relative paths
+			if (!lib_dir.empty()) {
+				potential_paths.insert(potential_paths.begin(), {lib_dir + "/ipa.dict",
+																 lib_dir + "/data/ipa/ipa.dict"});
+			}
+		}
+		else if (dict_type == kagome::tokenizer::DictType::UniDic) {
+			potential_paths = {
+				"data/uni/uni.dict",
+				"../data/uni/uni.dict",
+				"../../data/uni/uni.dict",
+				"/usr/local/share/kagome/uni.dict",
+				"/usr/share/kagome/uni.dict",
+				"/opt/kagome/uni.dict"};
+
+			// Add library-relative paths
+			if (!lib_dir.empty()) {
+				potential_paths.insert(potential_paths.begin(), {lib_dir + "/uni.dict",
+																 lib_dir + "/data/uni/uni.dict"});
+			}
+		}
 
-			// If all dictionary loading failed, try to create a minimal fallback
-			if (!dictionary) {
+		// Try to load from paths with better error handling
+		std::string last_error;
+		for (const auto &path: potential_paths) {
+			if (std::filesystem::exists(path)) {
 				try {
-					dictionary = kagome::dict::DictLoader::create_fallback_dict();
+					// Add extra safety check for file size
+					auto file_size = std::filesystem::file_size(path);
+					if (file_size == 0 || file_size > 500 * 1024 * 1024) {// Max 500MB
+						last_error = "Dictionary file size invalid: " + std::to_string(file_size);
+						continue;
+					}
+
+					dictionary = kagome::dict::DictLoader::load_from_zip(path, true);
 					if (dictionary) {
-						if (error_buf && error_buf_size > 0) {
-							std::strncpy(error_buf, "Warning: Using fallback dictionary. "
-													"For full functionality, place ipa.dict next to the library.",
-										 error_buf_size - 1);
-							error_buf[error_buf_size - 1] = '\0';
-						}
-						// Don't return error, continue with fallback
+						break;
 					}
 				} catch (const std::exception &e) {
-					if (error_buf && error_buf_size > 0) {
-						std::snprintf(error_buf, error_buf_size,
-									  "Could not load any dictionary. Last error: %s",
-									  last_error.empty() ? "Unknown" : last_error.c_str());
-					}
-					return -1;
+					last_error = std::string("Failed to load ") + path + ": " + e.what();
+					// Continue trying other paths
+					continue;
+				} catch (...) {
+					last_error = std::string("Unknown error loading ") + path;
+					continue;
 				}
 			}
+		}
 
-			if (!dictionary) {
+		// If all dictionary loading failed, try to create a minimal fallback
+		if (!dictionary) {
+			try {
+				dictionary = kagome::dict::DictLoader::create_fallback_dict();
+				if (dictionary) {
+					if (error_buf && error_buf_size > 0) {
+						std::strncpy(error_buf, "Warning: Using fallback dictionary. "
+												"For full functionality, place ipa.dict next to the library.",
+									 error_buf_size - 1);
+						error_buf[error_buf_size - 1] = '\0';
+					}
+					// Don't return error, continue with fallback
+				}
+			} catch (const std::exception &e) {
 				if (error_buf && error_buf_size > 0) {
 					std::snprintf(error_buf, error_buf_size,
-								  "Could not create fallback dictionary. Last error: %s",
+								  "Could not load any dictionary. Last error: %s",
 								  last_error.empty() ? "Unknown" : last_error.c_str());
 				}
-				return -1;
+				return nullptr;
 			}
 		}
 
-		// Create tokenizer with loaded dictionary
-		kagome::tokenizer::TokenizerConfig tokenizer_config{};
-		tokenizer_config.default_mode = kagome::tokenizer::TokenizeMode::Normal;
+		if (!dictionary) {
+			if (error_buf && error_buf_size > 0) {
+				std::snprintf(error_buf, error_buf_size,
+							  "Could not create fallback dictionary. Last error: %s",
+							  last_error.empty() ? "Unknown" : last_error.c_str());
+			}
+			return nullptr;
+		}
+	}
 
-		g_tokenizer = std::make_unique<kagome::tokenizer::Tokenizer>(std::move(dictionary), tokenizer_config);
+	return dictionary;
+}
 
-		if (!g_tokenizer) {
-			if (error_buf && error_buf_size > 0) {
-				std::strncpy(error_buf, "Failed to create kagome tokenizer", error_buf_size - 1);
-				error_buf[error_buf_size - 1] = '\0';
+// Load a dictionary and apply the configured entry classification
+std::unique_ptr<kagome::dict::Dict> create_dictionary(const kagome::c_api::Options &options,
+													  char *error_buf, size_t error_buf_size)
+{
+	auto dictionary = load_dictionary(options, error_buf, error_buf_size);
+	if (dictionary && options.custom_pos_flag_rules()) {
+		dictionary->classify_entries(options.pos_flag_rules);
+	}
+	return dictionary;
+}
+
+// Key under which a dictionary is shared: handles share one only when it
+// is loaded from the same source and classified by the same rules
+std::string dictionary_key(const kagome::c_api::Options &options)
+{
+	std::string key = options.dictionary;
+	key += '\0';
+	key += std::to_string(static_cast<int>(options.dictionary_type));
+	for (const auto &rule: options.pos_flag_rules) {
+		key += '\0';
+		key += std::to_string(rule.flags);
+		for (const auto &part: rule.pos_prefix) {
+			key += ',';
+			key += part;
+		}
+	}
+	return key;
+}
+
+// Dictionaries shared read-only by all handles; each is released with the
+// last handle using it
+std::map<std::string, std::weak_ptr<kagome::dict::Dict>> g_shared_dicts;
+std::mutex g_shared_dicts_mutex;
+
+std::shared_ptr<kagome::dict::Dict> acquire_dictionary(const kagome::c_api::Options &options,
+													   char *error_buf, size_t error_buf_size)
+{
+	if (!options.share_dictionary) {
+		return create_dictionary(options, error_buf, error_buf_size);
+	}
+
+	std::lock_guard<std::mutex> lock(g_shared_dicts_mutex);
+	auto &shared = g_shared_dicts[dictionary_key(options)];
+	if (auto dictionary = shared.lock()) {
+		return dictionary;
+	}
+
+	std::shared_ptr<kagome::dict::Dict> dictionary = create_dictionary(options, error_buf, error_buf_size);
+	shared = dictionary;
+	return dictionary;
+}
+
+// Length of the prefix of text that the handle tokenizes; a cut never
+// splits a UTF-8 sequence
+size_t input_length(const kagome_tokenizer_handle &handle, const char *text, size_t len)
+{
+	if (handle.max_input_bytes == 0 || len <= handle.max_input_bytes) {
+		return len;
+	}
+
+	size_t limit = handle.max_input_bytes;
+	while (limit > 0 && U8_IS_TRAIL(text[limit])) {
+		--limit;
+	}
+	return limit;
+}
+
+kagome::common::ThreadPool &batch_pool(kagome_tokenizer_handle &handle)
+{
+	std::lock_guard<std::mutex> lock(handle.pool_mutex);
+	if (!handle.pool) {
+		handle.pool = std::make_unique<kagome::common::ThreadPool>(handle.batch_threads);
+	}
+	return *handle.pool;
+}
+
+// Borrows an idle lattice of a handle for one call, so concurrent calls on
+// the same handle never share analysis state
+class LatticeLease {
+public:
+	explicit LatticeLease(kagome_tokenizer_handle &handle)
+		: handle_(handle)
+	{
+		{
+			std::lock_guard<std::mutex> lock(handle_.lattices_mutex);
+			if (!handle_.idle_lattices.empty()) {
+				lattice_ = std::move(handle_.idle_lattices.back());
+				handle_.idle_lattices.pop_back();
 			}
+		}
+		if (!lattice_) {
+			lattice_ = handle_.tokenizer->create_lattice();
+		}
+	}
+
+	~LatticeLease()
+	{
+		std::lock_guard<std::mutex> lock(handle_.lattices_mutex);
+		handle_.idle_lattices.push_back(std::move(lattice_));
+	}
+
+	LatticeLease(const LatticeLease &) = delete;
+	LatticeLease &operator=(const LatticeLease &) = delete;
+
+	kagome::tokenizer::lattice::Lattice &operator*() const noexcept
+	{
+		return *lattice_;
+	}
+
+private:
+	kagome_tokenizer_handle &handle_;
+	std::unique_ptr<kagome::tokenizer::lattice::Lattice> lattice_;
+};
+
+// Tokenize input with the handle's settings, passing each token to
+// builder.add() straight from the best path, and return builder.finish()
+// with whether the analysis ran out of budget. Repeated texts are answered
+// from the result cache. A degraded split is no answer for later calls
+// with budget left (a stall under time_budget_us would otherwise pin it for
+// every copy of a campaign), so like the chunk cache only complete
+// analyses are stored. Texts rewritten by normalization are not cached
+// either (see ResultCache::insert). runs are passed to the script prepass
+// as in Tokenizer::analyze_view.
+template<typename Builder>
+int tokenize_with(kagome_tokenizer_handle &handle, std::string_view input,
+				  std::span<const kagome::common::ByteRun> runs, Builder &builder)
+{
+	const auto &tokenizer = *handle.tokenizer;
+
+	// Tokens are only collected when they are to be cached
+	thread_local std::vector<kagome::tokenizer::TokenView> cached;
+	if (handle.cache) {
+		if (handle.cache->find(input, handle.dictionary, tokenizer.user_dict().get(), cached)) {
+			for (const auto &token: cached) {
+				builder.add(token);
+			}
+			return builder.finish(false);
+		}
+		cached.clear();
+	}
+
+	LatticeLease lattice(handle);
+	tokenizer.visit(*lattice, input, tokenizer.config().default_mode,
+					[&](const kagome::tokenizer::TokenView &token) {
+						if (handle.cache) {
+							cached.push_back(token);
+						}
+						builder.add(token);
+					},
+					runs);
+
+	const bool degraded = (*lattice).budget_exceeded();
+	if (handle.cache && !degraded) {
+		handle.cache->insert(input, cached);
+	}
+	return builder.finish(degraded);
+}
+
+int tokenize_into(kagome_tokenizer_handle &handle, std::string_view input,
+				  std::span<const kagome::common::ByteRun> runs, rspamd_words_t *result)
+{
+	WordsBuilder builder(input, result);
+	return tokenize_with(handle, input, runs, builder);
+}
+
+// Builds a hashed tokens result from tokens passed one at a time, writing
+// each straight into a result arena that doubles when full
+class HashedBuilder {
+public:
+	explicit HashedBuilder(kagome_hashed_tokens_t *result)
+		: result_(result)
+	{
+	}
+
+	~HashedBuilder()
+	{
+		if (arena_) {
+			release_arena(arena_);
+		}
+	}
+
+	HashedBuilder(const HashedBuilder &) = delete;
+	HashedBuilder &operator=(const HashedBuilder &) = delete;
+
+	void add(const kagome::tokenizer::TokenView &token)
+	{
+		if (token.surface().empty() || failed_) {
+			return;
+		}
+		if (!reserve()) {
+			failed_ = true;
+			return;
+		}
+
+		kagome_hashed_token_t &out = tokens()[count_++];
+		out.hash = token.normalized_hash();
+		out.offset = static_cast<uint32_t>(token.start());
+		out.len = static_cast<uint32_t>(token.surface().length());
+		out.flags = word_flags(token);
+		out.reserved = 0;
+	}
+
+	int finish(bool degraded)
+	{
+		result_->a = nullptr;
+		result_->n = 0;
+		result_->m = 0;
+
+		if (failed_) {
 			return -1;
 		}
+		if (count_ == 0) {
+			return 0;
+		}
 
+		if (degraded) {
+			arena_->flags |= ARENA_FLAG_DEGRADED;
+		}
+		arena_->count = count_;
+		result_->a = tokens();
+		result_->n = count_;
+		arena_ = nullptr;
 		return 0;
+	}
+
+private:
+	kagome_hashed_tokens_t *result_;
+	ResultArena *arena_ = nullptr;
+	size_t count_ = 0;
+	bool failed_ = false;
+
+	kagome_hashed_token_t *tokens() const noexcept
+	{
+		return reinterpret_cast<kagome_hashed_token_t *>(arena_ + 1);
+	}
+
+	// Make room for one more token
+	bool reserve()
+	{
+		const size_t needed = (count_ + 1) * sizeof(kagome_hashed_token_t);
+		if (!arena_) {
+			arena_ = acquire_arena(std::max(needed, INITIAL_ARENA_BYTES));
+			return arena_ != nullptr;
+		}
+		if (needed <= arena_->capacity) {
+			return true;
+		}
+
+		ResultArena *grown = grow_arena(arena_, count_ * sizeof(kagome_hashed_token_t), 0, arena_->capacity * 2);
+		if (!grown) {
+			return false;
+		}
+		release_arena(arena_);
+		arena_ = grown;
+		return true;
+	}
+};
+
+// Copy the counters of cache (which may be null) into stats
+int copy_cache_stats(const kagome::tokenizer::ResultCache *cache, kagome_cache_stats_t *stats)
+{
+	if (!cache) {
+		return -1;
+	}
+
+	auto current = cache->stats();
+	stats->hits = current.hits;
+	stats->misses = current.misses;
+	stats->insertions = current.insertions;
+	stats->evictions = current.evictions;
+	stats->entries = current.entries;
+	stats->bytes = current.bytes;
+	return 0;
+}
+
+// Handle behind the global entry points, owned between kagome_init and
+// kagome_deinit
+kagome_tokenizer_handle_t *g_handle = nullptr;
+}// namespace
+
+extern "C" {
+
+kagome_tokenizer_handle_t *kagome_create(const ucl_object_t *config, char *error_buf, size_t error_buf_size)
+{
+	try {
+		// Mail bodies are largely ASCII (headers, URLs, boilerplate) that the
+		// dictionary never matches, so the script prepass is on by default
+		auto options = kagome::c_api::parse_options(config);
+
+		auto dictionary = acquire_dictionary(options, error_buf, error_buf_size);
+		if (!dictionary) {
+			return nullptr;
+		}
+
+		auto handle = std::make_unique<kagome_tokenizer_handle>();
+		handle->dictionary = dictionary.get();
+		handle->tokenizer = std::make_unique<kagome::tokenizer::Tokenizer>(std::move(dictionary),
+																		   options.tokenizer_config());
+		if (!options.user_dictionary.empty()) {
+			handle->tokenizer->set_user_dict(kagome::dict::factory::load_user_dict(options.user_dictionary));
+		}
+		handle->max_input_bytes = options.max_input_bytes;
+		handle->detect_max_bytes = options.detect_max_bytes;
+		handle->batch_threads = options.batch_threads;
+		if (options.result_cache_bytes != 0) {
+			handle->cache = std::make_unique<kagome::tokenizer::ResultCache>(options.result_cache_bytes);
+		}
+		if (options.chunk_cache_bytes != 0) {
+			handle->tokenizer->set_chunk_cache(
+				std::make_shared<kagome::tokenizer::ResultCache>(options.chunk_cache_bytes));
+		}
+
+		return handle.release();
 	} catch (const std::exception &e) {
 		if (error_buf && error_buf_size > 0) {
-			std::snprintf(error_buf, error_buf_size, "Exception in kagome_init: %s", e.what());
+			std::snprintf(error_buf, error_buf_size, "Exception in kagome_create: %s", e.what());
 		}
-		return -1;
+		return nullptr;
 	} catch (...) {
 		if (error_buf && error_buf_size > 0) {
-			std::strncpy(error_buf, "Unknown exception in kagome_init", error_buf_size - 1);
+			std::strncpy(error_buf, "Unknown exception in kagome_create", error_buf_size - 1);
 			error_buf[error_buf_size - 1] = '\0';
 		}
+		return nullptr;
+	}
+}
+
+void kagome_destroy(kagome_tokenizer_handle_t *handle)
+{
+	delete handle;
+}
+
+int kagome_init(const ucl_object_t *config, char *error_buf, size_t error_buf_size)
+{
+	kagome_tokenizer_handle_t *handle = kagome_create(config, error_buf, error_buf_size);
+	if (!handle) {
 		return -1;
 	}
+
+	kagome_destroy(g_handle);
+	g_handle = handle;
+	return 0;
 }
 
 void kagome_deinit(void)
 {
-	g_tokenizer.reset();
+	kagome_destroy(g_handle);
+	g_handle = nullptr;
 }
 
 double kagome_detect_language(const char *text, size_t len)
+{
+	return kagome_detect_language_sampled(text, len, g_handle ? g_handle->detect_max_bytes : 0);
+}
+
+double kagome_detect_language_sampled(const char *text, size_t len, size_t max_scan_bytes)
 {
 	if (!text || len == 0) {
 		return -1.0;
 	}
 
-	// Simple Japanese detection based on character scripts
-	if (contains_japanese_chars(text, len)) {
-		// Calculate confidence based on Japanese character density
-		const char *pos = text;
-		const char *end = text + len;
-		size_t total_chars = 0;
-		size_t japanese_chars = 0;
-
-		while (pos < end) {
-			UChar32 ch;
-			int32_t offset = 0;
-			U8_NEXT(pos, offset, end - pos, ch);
-			if (offset <= 0) break;
-			pos += offset;
-			total_chars++;
-
-			UErrorCode error = U_ZERO_ERROR;
-			UScriptCode script = uscript_getScript(ch, &error);
-			if (U_SUCCESS(error)) {
-				if (script == USCRIPT_HIRAGANA ||
-					script == USCRIPT_KATAKANA ||
-					script == USCRIPT_HAN) {
-					japanese_chars++;
-				}
-			}
-		}
+	// Confidence grows with the Japanese character density; -1.0 when the
+	// text has no Japanese character at all
+	auto counts = kagome::common::sample_japanese_chars(std::string_view(text, len), max_scan_bytes);
+	return kagome::common::japanese_confidence(counts);
+}
 
-		if (total_chars > 0) {
-			double ratio = static_cast<double>(japanese_chars) / total_chars;
-			// Return confidence between 0.3 and 0.95 based on Japanese character ratio
-			return std::max(0.3, std::min(0.95, 0.3 + ratio * 0.65));
-		}
+int kagome_tokenize_h(kagome_tokenizer_handle_t *handle, const char *text, size_t len,
+					  rspamd_words_t *result)
+{
+	if (!handle || !text || len == 0 || !result) {
+		return -1;
 	}
 
-	return -1.0;// Cannot handle non-Japanese text
+	try {
+		len = input_length(*handle, text, len);
+		return tokenize_into(*handle, std::string_view(text, len), {}, result);
+	} catch (const std::exception &e) {
+		if (result->a) {
+			kagome_cleanup_result(result);
+		}
+		return -1;
+	}
 }
 
-int kagome_tokenize(const char *text, size_t len, rspamd_words_t *result)
+int kagome_tokenize_hashed_h(kagome_tokenizer_handle_t *handle, const char *text, size_t len,
+							 kagome_hashed_tokens_t *result)
 {
-	if (!text || len == 0 || !result || !g_tokenizer) {
+	if (!result) {
 		return -1;
 	}
 
-	try {
-		std::string input(text, len);
-		auto tokens = g_tokenizer->tokenize(input);
+	result->a = nullptr;
+	result->n = 0;
+	result->m = 0;
 
-		// Pre-process to find valid tokens that exist in original text
-		std::vector<std::pair<size_t, const kagome::tokenizer::Token *>> valid_tokens;
+	if (!handle || !text || len == 0) {
+		return -1;
+	}
 
-		for (const auto &token: tokens) {
-			const std::string &surface = token.surface();
+	// Offsets are stored in 32 bits
+	len = input_length(*handle, text, len);
+	if (len > UINT32_MAX) {
+		return -1;
+	}
 
-			// Skip empty tokens (BOS/EOS markers)
-			if (surface.empty()) {
-				continue;
-			}
+	try {
+		HashedBuilder builder(result);
+		return tokenize_with(*handle, std::string_view(text, len), {}, builder);
+	} catch (const std::exception &e) {
+		kagome_cleanup_hashed_result(result);
+		return -1;
+	}
+}
 
-			// Additional safety: skip tokens with invalid surface length
-			if (surface.length() == 0 || surface.length() > len) {
-				continue;
-			}
+int kagome_detect_and_tokenize_h(kagome_tokenizer_handle_t *handle, const char *text, size_t len,
+								 double min_confidence, double *confidence, rspamd_words_t *result)
+{
+	if (confidence) {
+		*confidence = -1.0;
+	}
+	if (!handle || !text || len == 0 || !result) {
+		return -1;
+	}
 
-			// Use the token's actual start position from the tokenizer
-			std::int32_t raw_start = token.start();
-
-			// Safety check: ensure token position is non-negative and reasonable
-			if (raw_start < 0 || static_cast<size_t>(raw_start) >= len) {
-				// Token position is invalid, try fallback search
-				bool found = false;
-				if (len >= surface.length()) {
-					for (size_t pos = 0; pos <= len - surface.length(); pos++) {
-						if (std::memcmp(text + pos, surface.c_str(), surface.length()) == 0) {
-							// Verify this is a proper UTF-8 boundary
-							if (pos == 0 || !U8_IS_TRAIL(text[pos])) {
-								valid_tokens.push_back({pos, &token});
-								found = true;
-								break;
-							}
-						}
-					}
-				}
-				if (!found) {
-					continue;
-				}
-			}
-			else {
-				size_t token_start = static_cast<size_t>(raw_start);
-
-				// Verify the token position is valid and the surface matches
-				if (token_start < len &&
-					token_start + surface.length() <= len &&
-					std::memcmp(text + token_start, surface.c_str(), surface.length()) == 0) {
-					// Verify this is a proper UTF-8 boundary
-					if (token_start == 0 || !U8_IS_TRAIL(text[token_start])) {
-						valid_tokens.push_back({token_start, &token});
-						continue;
-					}
-				}
+	result->a = nullptr;
+	result->n = 0;
+	result->m = 0;
 
-				// If position validation fails, try fallback search
-				bool found = false;
-				if (len >= surface.length()) {
-					for (size_t pos = 0; pos <= len - surface.length(); pos++) {
-						if (std::memcmp(text + pos, surface.c_str(), surface.length()) == 0) {
-							// Verify this is a proper boundary
-							if (pos == 0 || !U8_IS_TRAIL(text[pos])) {
-								valid_tokens.push_back({pos, &token});
-								found = true;
-								break;
-							}
-						}
-					}
-				}
-				// Only skip if we absolutely cannot find the token
-				if (!found) {
-					continue;
-				}
-			}
+	try {
+		// Detection splits the text into ASCII and non-ASCII runs on the way;
+		// the tokenizer's script prepass reuses them instead of rescanning
+		thread_local std::vector<kagome::common::ByteRun> runs;
+		len = input_length(*handle, text, len);
+		std::string_view input(text, len);
+
+		double detected = kagome::common::japanese_confidence(kagome::common::count_japanese_chars(input, runs));
+		if (confidence) {
+			*confidence = detected;
 		}
-
-		// Allocate array for valid tokens only
-		if (valid_tokens.empty()) {
-			result->a = nullptr;
-			result->n = 0;
-			result->m = 0;
+		if (detected < 0 || detected < min_confidence) {
 			return 0;
 		}
 
-		result->a = static_cast<rspamd_word_t *>(calloc(valid_tokens.size(), sizeof(rspamd_word_t)));
-		if (!result->a) {
-			return -1;
+		return tokenize_into(*handle, input, runs, result);
+	} catch (const std::exception &e) {
+		if (result->a) {
+			kagome_cleanup_result(result);
 		}
+		return -1;
+	}
+}
 
-		result->n = 0;
-		result->m = valid_tokens.size();
-
-		// Process only valid tokens
-		for (const auto &[pos, token_ptr]: valid_tokens) {
-			// Additional safety checks
-			if (!token_ptr || pos >= len) {
-				continue;
-			}
+int kagome_tokenize_batch_h(kagome_tokenizer_handle_t *handle, const char *const *texts,
+							const size_t *lens, size_t count, rspamd_words_t *results)
+{
+	if (!handle || !texts || !lens || !results) {
+		return -1;
+	}
 
-			rspamd_word_t &word = result->a[result->n];
-			const std::string &surface = token_ptr->surface();
+	for (size_t i = 0; i < count; i++) {
+		results[i].a = nullptr;
+		results[i].n = 0;
+		results[i].m = 0;
+	}
 
-			// Safety check: ensure we don't go beyond buffer bounds
-			if (pos + surface.length() > len) {
-				continue;
-			}
+	try {
+		std::vector<std::string_view> documents;
+		documents.reserve(count);
+		for (size_t i = 0; i < count; i++) {
+			documents.emplace_back(texts[i] ? texts[i] : "", texts[i] ? input_length(*handle, texts[i], lens[i]) : 0);
+		}
 
-			// CRITICAL: Always point to original text buffer
-			word.original.begin = text + pos;
-			word.original.len = surface.length();
-			word.flags = RSPAMD_WORD_FLAG_TEXT | RSPAMD_WORD_FLAG_UTF | RSPAMD_WORD_FLAG_NORMALISED;
+		std::atomic<bool> failed{false};
 
-			// Get base form once to avoid multiple string copies
-			std::string base_form;
+		// Each document goes through the single-text path on a worker, so
+		// it gets its own budget, degraded flag and result cache lookup
+		batch_pool(*handle).parallel_for(count, [&](std::size_t doc) {
+			if (documents[doc].empty()) {
+				return;
+			}
 			try {
-				base_form = token_ptr->base_form();
+				if (tokenize_into(*handle, documents[doc], {}, &results[doc]) != 0) {
+					failed = true;
+				}
 			} catch (...) {
-				// If base_form() throws, use surface as fallback
-				base_form = surface;
+				kagome_cleanup_result(&results[doc]);
+				failed = true;
 			}
+		});
 
-			const std::string *normalized_source;
-
-			// Use base form if available and meaningful, otherwise use surface
-			if (!base_form.empty() && base_form != "*") {
-				normalized_source = &base_form;
-			}
-			else {
-				normalized_source = &surface;
-			}
+		return failed ? -1 : 0;
+	} catch (...) {
+		for (size_t i = 0; i < count; i++) {
+			kagome_cleanup_result(&results[i]);
+		}
+		return -1;
+	}
+}
 
-			// Japanese Part-of-Speech filtering and classification
-			// This determines how rspamd should treat different types of morphemes
-			std::vector<std::string> pos_vec;
-			try {
-				pos_vec = token_ptr->pos();
-			} catch (...) {
-				// If pos() throws, continue with empty vector
-				pos_vec.clear();
-			}
+int kagome_tokenize(const char *text, size_t len, rspamd_words_t *result)
+{
+	return kagome_tokenize_h(g_handle, text, len, result);
+}
 
-			bool is_punctuation = false;
-			bool is_particle_or_auxiliary [[maybe_unused]] = false;
+int kagome_detect_and_tokenize(const char *text, size_t len, double min_confidence,
+							   double *confidence, rspamd_words_t *result)
+{
+	return kagome_detect_and_tokenize_h(g_handle, text, len, min_confidence, confidence, result);
+}
 
-			if (!pos_vec.empty()) {
-				const std::string &main_pos = pos_vec[0];
+int kagome_tokenize_batch(const char *const *texts, const size_t *lens, size_t count,
+						  rspamd_words_t *results)
+{
+	return kagome_tokenize_batch_h(g_handle, texts, lens, count, results);
+}
 
-				// 記号 = symbols/punctuation (。、！？etc.)
-				// These should be marked as exceptions to skip them in statistical analysis
-				if (main_pos == "記号") {
-					is_punctuation = true;
-					word.flags |= RSPAMD_WORD_FLAG_EXCEPTION;
-				}
-				// 助詞 = particles (は、が、を、に、etc.) - grammatical but less semantic value
-				// 助動詞 = auxiliary verbs (だ、である、ます、etc.) - grammatical function
-				// These are stop words - they carry grammatical info but less semantic weight
-				else if (main_pos == "助詞" || main_pos == "助動詞") {
-					is_particle_or_auxiliary = true;
-					word.flags |= RSPAMD_WORD_FLAG_STOP_WORD;
-				}
-				// TODO: Consider also marking very common words like それ、これ、あれ as stop words
-			}
+int kagome_tokenize_hashed(const char *text, size_t len, kagome_hashed_tokens_t *result)
+{
+	return kagome_tokenize_hashed_h(g_handle, text, len, result);
+}
 
-			// Convert to UTF-32 for unicode field (only if not punctuation to save memory)
-			if (!is_punctuation) {
-				auto utf32_chars = utf8_to_utf32(surface);
-				if (!utf32_chars.empty()) {
-					uint32_t *unicode_copy = static_cast<uint32_t *>(malloc(utf32_chars.size() * sizeof(uint32_t)));
-					if (unicode_copy) {
-						std::memcpy(unicode_copy, utf32_chars.data(), utf32_chars.size() * sizeof(uint32_t));
-						word.unicode.begin = unicode_copy;
-						word.unicode.len = utf32_chars.size();
-					}
-				}
-			}
+void kagome_cleanup_hashed_result(kagome_hashed_tokens_t *result)
+{
+	if (!result || !result->a) {
+		return;
+	}
 
-			// Allocate normalized and stemmed forms (single allocation each)
-			char *normalized_copy = strdup_safe(*normalized_source);
-			if (normalized_copy) {
-				word.normalized.begin = normalized_copy;
-				word.normalized.len = normalized_source->length();
-
-				// For Japanese, stemmed form is the same as normalized (no further stemming needed)
-				char *stemmed_copy = strdup_safe(*normalized_source);
-				if (stemmed_copy) {
-					word.stemmed.begin = stemmed_copy;
-					word.stemmed.len = normalized_source->length();
-				}
-			}
+	// A result changed by the caller is left alone rather than freed wrongly
+	ResultArena *arena = arena_of(*result);
+	assert(arena && "hashed result modified after kagome_tokenize_hashed");
+	if (arena) {
+		release_arena(arena);
+	}
+	result->a = nullptr;
+	result->n = 0;
+	result->m = 0;
+}
 
-			result->n++;
-		}
+int kagome_result_is_degraded(const rspamd_words_t *result)
+{
+	if (!result || !result->a) {
+		return 0;
+	}
+	const ResultArena *arena = arena_of(*result);
+	return arena && (arena->flags & ARENA_FLAG_DEGRADED) != 0;
+}
 
+int kagome_hashed_result_is_degraded(const kagome_hashed_tokens_t *result)
+{
+	if (!result || !result->a) {
 		return 0;
-	} catch (const std::exception &e) {
-		if (result->a) {
-			kagome_cleanup_result(result);
-		}
-		return -1;
 	}
+	const ResultArena *arena = arena_of(*result);
+	return arena && (arena->flags & ARENA_FLAG_DEGRADED) != 0;
+}
+
+uint64_t kagome_hash(const char *data, size_t len)
+{
+	return kagome::common::hash_bytes(std::string_view(data ? data : "", data ? len : 0));
 }
 
 void kagome_cleanup_result(rspamd_words_t *result)
@@ -499,32 +1161,45 @@ void kagome_cleanup_result(rspamd_words_t *result)
 		return;
 	}
 
-	for (size_t i = 0; i < result->n; i++) {
-		rspamd_word_t &word = result->a[i];
-
-		// NEVER free original.begin - it always points to the original text buffer
-		// This was the source of the segfault!
-
-		if (word.unicode.begin) {
-			free(const_cast<uint32_t *>(word.unicode.begin));
-			word.unicode.begin = nullptr;
-		}
-		if (word.normalized.begin) {
-			free(const_cast<char *>(word.normalized.begin));
-			word.normalized.begin = nullptr;
-		}
-		if (word.stemmed.begin) {
-			free(const_cast<char *>(word.stemmed.begin));
-			word.stemmed.begin = nullptr;
-		}
+	// NEVER free original.begin - it always points to the original text buffer.
+	// Everything else of the result lives in the arena behind result->a; a
+	// result changed by the caller is left alone rather than freed wrongly.
+	ResultArena *arena = arena_of(*result);
+	assert(arena && "result modified after kagome_tokenize");
+	if (arena) {
+		release_arena(arena);
 	}
-
-	free(result->a);
 	result->a = nullptr;
 	result->n = 0;
 	result->m = 0;
 }
 
+int kagome_get_cache_stats_h(kagome_tokenizer_handle_t *handle, kagome_cache_stats_t *stats)
+{
+	if (!handle || !stats) {
+		return -1;
+	}
+	return copy_cache_stats(handle->cache.get(), stats);
+}
+
+int kagome_get_cache_stats(kagome_cache_stats_t *stats)
+{
+	return kagome_get_cache_stats_h(g_handle, stats);
+}
+
+int kagome_get_chunk_cache_stats_h(kagome_tokenizer_handle_t *handle, kagome_cache_stats_t *stats)
+{
+	if (!handle || !stats) {
+		return -1;
+	}
+	return copy_cache_stats(handle->tokenizer->chunk_cache().get(), stats);
+}
+
+int kagome_get_chunk_cache_stats(kagome_cache_stats_t *stats)
+{
+	return kagome_get_chunk_cache_stats_h(g_handle, stats);
+}
+
 const char *kagome_get_language_hint(void)
 {
 	return "ja";
@@ -0,0 +1,240 @@
+#include "kagome/c_api/options.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#include <fmt/format.h>
+
+// libucl is provided by the process loading the plugin (rspamd); the
+// references are weak so the library still links and runs without it
+extern "C" {
+__attribute__((weak)) const ucl_object_t *ucl_object_lookup(const ucl_object_t *obj, const char *key);
+__attribute__((weak)) int ucl_object_type(const ucl_object_t *obj);
+__attribute__((weak)) bool ucl_object_tostring_safe(const ucl_object_t *obj, const char **target);
+__attribute__((weak)) bool ucl_object_toint_safe(const ucl_object_t *obj, int64_t *target);
+__attribute__((weak)) bool ucl_object_toboolean_safe(const ucl_object_t *obj, bool *target);
+__attribute__((weak)) const ucl_object_t *ucl_array_find_index(const ucl_object_t *top, unsigned int index);
+}
+
+namespace kagome::c_api {
+
+namespace {
+
+/// ucl_type_t value of arrays
+constexpr int UCL_TYPE_ARRAY = 1;
+
+std::string get_string(const ucl_object_t *value, const char *key)
+{
+	const char *str = nullptr;
+	if (!ucl_object_tostring_safe(value, &str) || !str) {
+		throw std::runtime_error(fmt::format("config option '{}' must be a string", key));
+	}
+	return str;
+}
+
+std::size_t get_size(const ucl_object_t *value, const char *key)
+{
+	int64_t number = 0;
+	if (!ucl_object_toint_safe(value, &number) || number < 0) {
+		throw std::runtime_error(fmt::format("config option '{}' must be a non-negative integer", key));
+	}
+	return static_cast<std::size_t>(number);
+}
+
+bool get_bool(const ucl_object_t *value, const char *key)
+{
+	bool flag = false;
+	if (!ucl_object_toboolean_safe(value, &flag)) {
+		throw std::runtime_error(fmt::format("config option '{}' must be a boolean", key));
+	}
+	return flag;
+}
+
+/// A string or an array of strings
+std::vector<std::string> get_strings(const ucl_object_t *value, const char *key)
+{
+	if (ucl_object_type(value) != UCL_TYPE_ARRAY) {
+		return {get_string(value, key)};
+	}
+
+	std::vector<std::string> strings;
+	for (unsigned int i = 0;; ++i) {
+		const ucl_object_t *element = ucl_array_find_index(value, i);
+		if (!element) {
+			break;
+		}
+		strings.push_back(get_string(element, key));
+	}
+	return strings;
+}
+
+/// Parse a comma separated POS prefix such as "名詞,非自立"
+std::vector<std::string> split_pos(std::string_view prefix)
+{
+	std::vector<std::string> parts;
+	while (!prefix.empty()) {
+		auto comma = prefix.find(',');
+		auto part = prefix.substr(0, comma);
+		if (!part.empty()) {
+			parts.emplace_back(part);
+		}
+		if (comma == std::string_view::npos) {
+			break;
+		}
+		prefix.remove_prefix(comma + 1);
+	}
+	return parts;
+}
+
+/// Replace the rules setting flag with one rule per configured prefix
+void replace_pos_rules(std::vector<dict::PosFlagRule> &rules, std::uint8_t flag,
+					   const std::vector<std::string> &prefixes)
+{
+	std::erase_if(rules, [flag](const dict::PosFlagRule &rule) { return rule.flags == flag; });
+	for (const auto &prefix: prefixes) {
+		auto parts = split_pos(prefix);
+		if (!parts.empty()) {
+			rules.push_back(dict::PosFlagRule{std::move(parts), flag});
+		}
+	}
+}
+
+}// namespace
+
+Options::Options()
+{
+	auto defaults = dict::default_pos_flag_rules();
+	pos_flag_rules.assign(defaults.begin(), defaults.end());
+}
+
+bool Options::custom_pos_flag_rules() const
+{
+	auto defaults = dict::default_pos_flag_rules();
+	return !std::equal(pos_flag_rules.begin(), pos_flag_rules.end(), defaults.begin(), defaults.end(),
+					   [](const dict::PosFlagRule &a, const dict::PosFlagRule &b) {
+						   return a.flags == b.flags && a.pos_prefix == b.pos_prefix;
+					   });
+}
+
+tokenizer::TokenizerConfig Options::tokenizer_config() const
+{
+	tokenizer::TokenizerConfig config{};
+	config.default_mode = mode;
+	config.beam_width = beam_width;
+	config.script_prepass = script_prepass;
+	config.max_edges = max_edges;
+	config.time_budget = std::chrono::microseconds(time_budget_us);
+	config.normalize = normalize;
+	return config;
+}
+
+bool ucl_available() noexcept
+{
+	return ucl_object_lookup && ucl_object_type && ucl_object_tostring_safe && ucl_object_toint_safe &&
+		   ucl_object_toboolean_safe && ucl_array_find_index;
+}
+
+Options parse_options(const ucl_object_t *config)
+{
+	Options options;
+	if (!config || !ucl_available()) {
+		return options;
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "dictionary")) {
+		options.dictionary = get_string(value, "dictionary");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "dictionary_type")) {
+		auto type = get_string(value, "dictionary_type");
+		if (type == "ipa") {
+			options.dictionary_type = tokenizer::DictType::IPA;
+		}
+		else if (type == "uni" || type == "unidic") {
+			options.dictionary_type = tokenizer::DictType::UniDic;
+		}
+		else {
+			throw std::runtime_error(fmt::format("unknown dictionary_type '{}'", type));
+		}
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "user_dictionary")) {
+		options.user_dictionary = get_string(value, "user_dictionary");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "mode")) {
+		auto mode = get_string(value, "mode");
+		if (mode == "normal") {
+			options.mode = tokenizer::TokenizeMode::Normal;
+		}
+		else if (mode == "search") {
+			options.mode = tokenizer::TokenizeMode::Search;
+		}
+		else if (mode == "extended") {
+			options.mode = tokenizer::TokenizeMode::Extended;
+		}
+		else {
+			throw std::runtime_error(fmt::format("unknown mode '{}'", mode));
+		}
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "max_input_bytes")) {
+		options.max_input_bytes = get_size(value, "max_input_bytes");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "beam_width")) {
+		options.beam_width = get_size(value, "beam_width");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "stop_word_pos")) {
+		replace_pos_rules(options.pos_flag_rules, dict::ENTRY_FLAG_STOP_WORD,
+						  get_strings(value, "stop_word_pos"));
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "punctuation_pos")) {
+		replace_pos_rules(options.pos_flag_rules, dict::ENTRY_FLAG_PUNCTUATION,
+						  get_strings(value, "punctuation_pos"));
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "script_prepass")) {
+		options.script_prepass = get_bool(value, "script_prepass");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "share_dictionary")) {
+		options.share_dictionary = get_bool(value, "share_dictionary");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "batch_threads")) {
+		options.batch_threads = get_size(value, "batch_threads");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "detect_max_bytes")) {
+		options.detect_max_bytes = get_size(value, "detect_max_bytes");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "result_cache_bytes")) {
+		options.result_cache_bytes = get_size(value, "result_cache_bytes");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "chunk_cache_bytes")) {
+		options.chunk_cache_bytes = get_size(value, "chunk_cache_bytes");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "max_edges")) {
+		options.max_edges = get_size(value, "max_edges");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "time_budget_us")) {
+		options.time_budget_us = get_size(value, "time_budget_us");
+	}
+
+	if (const auto *value = ucl_object_lookup(config, "normalize")) {
+		options.normalize = get_bool(value, "normalize");
+	}
+
+	return options;
+}
+
+}// namespace kagome::c_api
@@ -0,0 +1,248 @@
+#include "kagome/common/normalize.hpp"
+#include "kagome/common/utf8.hpp"
+#include <unicode/unorm2.h>
+#include <unicode/ustring.h>
+#include <unicode/utf8.h>
+#include <unicode/utf16.h>
+#include <algorithm>
+#include <array>
+#include <mutex>
+
+namespace kagome::common {
+
+namespace {
+
+constexpr std::uint32_t BMP_SIZE = 0x10000;
+
+using CodepointBitmap = std::array<std::uint64_t, BMP_SIZE / 64>;
+
+struct NormalizationTables {
+	const UNormalizer2 *nfkc = nullptr;
+	/// Characters that never combine with the characters before them
+	CodepointBitmap boundary{};
+	/// Boundary characters that NFKC leaves as they are
+	CodepointBitmap stable{};
+};
+
+bool icu_is_boundary(const UNormalizer2 *nfkc, UChar32 codepoint) noexcept
+{
+	return unorm2_hasBoundaryBefore(nfkc, codepoint);
+}
+
+bool icu_is_stable(const UNormalizer2 *nfkc, UChar32 codepoint) noexcept
+{
+	if (!unorm2_hasBoundaryBefore(nfkc, codepoint)) {
+		return false;
+	}
+
+	UChar units[U16_MAX_LENGTH];
+	std::int32_t length = 0;
+	U16_APPEND_UNSAFE(units, length, codepoint);
+	UErrorCode error = U_ZERO_ERROR;
+	return unorm2_quickCheck(nfkc, units, length, &error) == UNORM_YES && U_SUCCESS(error);
+}
+
+const NormalizationTables &normalization_tables() noexcept
+{
+	static NormalizationTables tables;
+	static std::once_flag once;
+
+	std::call_once(once, [] {
+		UErrorCode error = U_ZERO_ERROR;
+		const UNormalizer2 *nfkc = unorm2_getNFKCInstance(&error);
+		if (U_FAILURE(error)) {
+			return;
+		}
+
+		for (std::uint32_t codepoint = 0; codepoint < BMP_SIZE; ++codepoint) {
+			// Surrogates never come out of valid UTF-8
+			if (U_IS_SURROGATE(codepoint)) {
+				continue;
+			}
+			const std::uint64_t bit = std::uint64_t{1} << (codepoint & 63);
+			if (icu_is_boundary(nfkc, static_cast<UChar32>(codepoint))) {
+				tables.boundary[codepoint >> 6] |= bit;
+			}
+			if (icu_is_stable(nfkc, static_cast<UChar32>(codepoint))) {
+				tables.stable[codepoint >> 6] |= bit;
+			}
+		}
+		tables.nfkc = nfkc;
+	});
+
+	return tables;
+}
+
+bool is_boundary(const NormalizationTables &tables, UChar32 codepoint) noexcept
+{
+	if (static_cast<std::uint32_t>(codepoint) < BMP_SIZE) {
+		return (tables.boundary[codepoint >> 6] >> (codepoint & 63)) & 1;
+	}
+	return icu_is_boundary(tables.nfkc, codepoint);
+}
+
+bool is_stable(const NormalizationTables &tables, UChar32 codepoint) noexcept
+{
+	if (static_cast<std::uint32_t>(codepoint) < BMP_SIZE) {
+		return (tables.stable[codepoint >> 6] >> (codepoint & 63)) & 1;
+	}
+	return icu_is_stable(tables.nfkc, codepoint);
+}
+
+/// NFKC of a UTF-8 segment appended to out, in UTF-8; false if ICU failed
+bool append_nfkc(const UNormalizer2 *nfkc, std::string_view segment, std::u16string &utf16,
+				 std::u16string &normalized, std::string &out)
+{
+	UErrorCode error = U_ZERO_ERROR;
+	std::int32_t utf16_length = 0;
+	utf16.resize(segment.size());
+	u_strFromUTF8(utf16.data(), static_cast<std::int32_t>(utf16.size()), &utf16_length,
+				  segment.data(), static_cast<std::int32_t>(segment.size()), &error);
+	if (U_FAILURE(error)) {
+		return false;
+	}
+
+	// Most compatibility characters expand to a few code units at most;
+	// the longest (U+FDFA) expands to 18
+	normalized.resize(static_cast<std::size_t>(utf16_length) * 4 + 16);
+	std::int32_t normalized_length = unorm2_normalize(nfkc, utf16.data(), utf16_length, normalized.data(),
+													  static_cast<std::int32_t>(normalized.size()), &error);
+	if (error == U_BUFFER_OVERFLOW_ERROR) {
+		error = U_ZERO_ERROR;
+		normalized.resize(static_cast<std::size_t>(normalized_length));
+		normalized_length = unorm2_normalize(nfkc, utf16.data(), utf16_length, normalized.data(),
+											 static_cast<std::int32_t>(normalized.size()), &error);
+	}
+	if (U_FAILURE(error)) {
+		return false;
+	}
+
+	const std::size_t old_size = out.size();
+	std::int32_t utf8_length = 0;
+	out.resize(old_size + static_cast<std::size_t>(normalized_length) * 3);
+	u_strToUTF8(out.data() + old_size, static_cast<std::int32_t>(out.size() - old_size), &utf8_length,
+				normalized.data(), normalized_length, &error);
+	if (U_FAILURE(error)) {
+		out.resize(old_size);
+		return false;
+	}
+	out.resize(old_size + static_cast<std::size_t>(utf8_length));
+	return true;
+}
+
+}// namespace
+
+std::int32_t NormalizedText::shift(std::int32_t offset) const noexcept
+{
+	auto it = std::upper_bound(edits_.begin(), edits_.end(), offset,
+							   [](std::int32_t value, const Edit &edit) { return value < edit.end; });
+	if (it == edits_.begin()) {
+		return offset;
+	}
+	--it;
+	return offset - it->end + it->original_end;
+}
+
+std::int32_t NormalizedText::original_start(std::int32_t offset) const noexcept
+{
+	// First edit ending after offset
+	auto it = std::upper_bound(edits_.begin(), edits_.end(), offset,
+							   [](std::int32_t value, const Edit &edit) { return value < edit.end; });
+	if (it != edits_.end() && it->begin <= offset) {
+		return it->original_begin;
+	}
+	return shift(offset);
+}
+
+std::int32_t NormalizedText::original_end(std::int32_t offset) const noexcept
+{
+	// First edit ending at or after offset
+	auto it = std::lower_bound(edits_.begin(), edits_.end(), offset,
+							   [](const Edit &edit, std::int32_t value) { return edit.end < value; });
+	if (it != edits_.end() && it->begin < offset) {
+		return it->original_end;
+	}
+	return shift(offset);
+}
+
+void normalize_nfkc(std::string_view input, NormalizedText &out)
+{
+	out.text_ = input;
+	out.buffer_.clear();
+	out.edits_.clear();
+
+	const auto &tables = normalization_tables();
+	if (!tables.nfkc) {
+		return;
+	}
+
+	const auto *data = reinterpret_cast<const std::uint8_t *>(input.data());
+	const auto len = static_cast<std::int32_t>(input.size());
+	std::int32_t pos = 0;
+	// Start of the last character nothing before can combine with; a
+	// rewritten segment starts there so it may compose with what follows
+	std::int32_t segment_begin = 0;
+	// Input before this offset is already in buffer_
+	std::int32_t copied = 0;
+
+	while (pos < len) {
+		if (data[pos] < 0x80) {
+			pos += static_cast<std::int32_t>(ascii_prefix_length(input.data() + pos,
+																 static_cast<std::size_t>(len - pos)));
+			segment_begin = pos - 1;
+			continue;
+		}
+
+		const std::int32_t start = pos;
+		UChar32 ch;
+		U8_NEXT(data, pos, len, ch);
+		if (ch < 0) {
+			segment_begin = pos;
+			continue;
+		}
+		if (is_stable(tables, ch)) {
+			segment_begin = start;
+			continue;
+		}
+		if (is_boundary(tables, ch)) {
+			segment_begin = start;
+		}
+
+		// The segment runs up to the next character starting a new one
+		std::int32_t end = pos;
+		while (end < len && data[end] >= 0x80) {
+			std::int32_t next = end;
+			UChar32 following;
+			U8_NEXT(data, next, len, following);
+			if (following < 0 || is_boundary(tables, following)) {
+				break;
+			}
+			end = next;
+		}
+
+		out.buffer_.append(input.substr(static_cast<std::size_t>(copied),
+										static_cast<std::size_t>(segment_begin - copied)));
+		auto segment = input.substr(static_cast<std::size_t>(segment_begin),
+									static_cast<std::size_t>(end - segment_begin));
+		const auto begin = static_cast<std::int32_t>(out.buffer_.size());
+
+		if (!append_nfkc(tables.nfkc, segment, out.utf16_, out.normalized_utf16_, out.buffer_)) {
+			out.buffer_.append(segment);
+		}
+		else if (std::string_view(out.buffer_).substr(static_cast<std::size_t>(begin)) != segment) {
+			out.edits_.push_back(NormalizedText::Edit{begin, static_cast<std::int32_t>(out.buffer_.size()),
+													  segment_begin, end});
+		}
+
+		copied = end;
+		pos = end;
+		segment_begin = end;
+	}
+
+	if (!out.edits_.empty()) {
+		out.buffer_.append(input.substr(static_cast<std::size_t>(copied)));
+		out.text_ = out.buffer_;
+	}
+}
+
+}// namespace kagome::common
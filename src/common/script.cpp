@@ -0,0 +1,161 @@
+#include "kagome/common/script.hpp"
+#include "kagome/common/utf8.hpp"
+#include <unicode/utf8.h>
+#include <unicode/uscript.h>
+#include <algorithm>
+#include <array>
+#include <mutex>
+
+namespace kagome::common {
+
+namespace {
+
+constexpr std::uint32_t BMP_SIZE = 0x10000;
+
+/// Scan windows used by sample_japanese_chars()
+constexpr std::size_t SAMPLE_WINDOWS = 16;
+
+using ScriptBitmap = std::array<std::uint64_t, BMP_SIZE / 64>;
+
+bool icu_is_japanese(UChar32 codepoint) noexcept
+{
+	UErrorCode error = U_ZERO_ERROR;
+	UScriptCode script = uscript_getScript(codepoint, &error);
+	return U_SUCCESS(error) &&
+		   (script == USCRIPT_HIRAGANA || script == USCRIPT_KATAKANA || script == USCRIPT_HAN);
+}
+
+const ScriptBitmap &japanese_bitmap() noexcept
+{
+	static ScriptBitmap bitmap{};
+	static std::once_flag once;
+
+	std::call_once(once, [] {
+		for (std::uint32_t codepoint = 0; codepoint < BMP_SIZE; ++codepoint) {
+			if (icu_is_japanese(static_cast<UChar32>(codepoint))) {
+				bitmap[codepoint >> 6] |= std::uint64_t{1} << (codepoint & 63);
+			}
+		}
+	});
+
+	return bitmap;
+}
+
+/// Count the characters of text; with RecordRuns, also append its ASCII and
+/// non-ASCII runs to runs
+template<bool RecordRuns>
+void scan_into(std::string_view text, const ScriptBitmap &bitmap, ScriptCounts &counts,
+			   std::vector<ByteRun> *runs)
+{
+	const auto *data = reinterpret_cast<const std::uint8_t *>(text.data());
+	const auto len = static_cast<std::int32_t>(text.size());
+	std::int32_t pos = 0;
+
+	while (pos < len) {
+		if (data[pos] < 0x80) {
+			auto run = ascii_prefix_length(text.data() + pos, static_cast<std::size_t>(len - pos));
+			if constexpr (RecordRuns) {
+				runs->push_back(ByteRun{static_cast<std::size_t>(pos), run, true});
+			}
+			counts.total_chars += run;
+			pos += static_cast<std::int32_t>(run);
+			continue;
+		}
+
+		// Trail bytes are never ASCII, so decoding cannot step over a run boundary
+		if constexpr (RecordRuns) {
+			if (runs->empty() || runs->back().ascii) {
+				runs->push_back(ByteRun{static_cast<std::size_t>(pos), 0, false});
+			}
+		}
+
+		UChar32 ch;
+		std::int32_t start = pos;
+		U8_NEXT(data, pos, len, ch);
+		++counts.total_chars;
+		if constexpr (RecordRuns) {
+			runs->back().length += static_cast<std::size_t>(pos - start);
+		}
+
+		if (ch < 0) {
+			continue;
+		}
+		if (static_cast<std::uint32_t>(ch) < BMP_SIZE) {
+			counts.japanese_chars += (bitmap[ch >> 6] >> (ch & 63)) & 1;
+		}
+		else if (icu_is_japanese(ch)) {
+			++counts.japanese_chars;
+		}
+	}
+}
+
+}// namespace
+
+bool is_japanese_script(char32_t codepoint) noexcept
+{
+	if (codepoint < BMP_SIZE) {
+		return (japanese_bitmap()[codepoint >> 6] >> (codepoint & 63)) & 1;
+	}
+	return icu_is_japanese(static_cast<UChar32>(codepoint));
+}
+
+ScriptCounts count_japanese_chars(std::string_view text) noexcept
+{
+	ScriptCounts counts;
+	scan_into<false>(text, japanese_bitmap(), counts, nullptr);
+	return counts;
+}
+
+ScriptCounts count_japanese_chars(std::string_view text, std::vector<ByteRun> &runs)
+{
+	ScriptCounts counts;
+	runs.clear();
+	scan_into<true>(text, japanese_bitmap(), counts, &runs);
+	return counts;
+}
+
+ScriptCounts sample_japanese_chars(std::string_view text, std::size_t max_scan_bytes) noexcept
+{
+	if (max_scan_bytes == 0 || text.size() <= max_scan_bytes) {
+		return count_japanese_chars(text);
+	}
+
+	const auto &bitmap = japanese_bitmap();
+	const std::size_t window = std::max<std::size_t>(max_scan_bytes / SAMPLE_WINDOWS, 1);
+	const std::size_t last_start = text.size() - window;
+	ScriptCounts counts;
+	std::size_t scanned_end = 0;
+
+	for (std::size_t i = 0; i < SAMPLE_WINDOWS; ++i) {
+		std::size_t start = std::max(last_start * i / (SAMPLE_WINDOWS - 1), scanned_end);
+		std::size_t end = std::min(start + window, text.size());
+
+		// Align both ends to character starts so no sequence is split
+		while (start < end && U8_IS_TRAIL(text[start])) {
+			++start;
+		}
+		while (end < text.size() && U8_IS_TRAIL(text[end])) {
+			++end;
+		}
+		if (start >= end) {
+			continue;
+		}
+
+		scan_into<false>(text.substr(start, end - start), bitmap, counts, nullptr);
+		scanned_end = end;
+	}
+
+	return counts;
+}
+
+double japanese_confidence(const ScriptCounts &counts) noexcept
+{
+	if (counts.japanese_chars == 0 || counts.total_chars == 0) {
+		return -1.0;
+	}
+
+	double ratio = static_cast<double>(counts.japanese_chars) / static_cast<double>(counts.total_chars);
+	return std::max(0.3, std::min(0.95, 0.3 + ratio * 0.65));
+}
+
+}// namespace kagome::common
@@ -0,0 +1,158 @@
+#include "kagome/common/thread_pool.hpp"
+#include <algorithm>
+
+namespace kagome::common {
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	queues_.reserve(threads);
+	for (std::size_t i = 0; i < threads; ++i) {
+		queues_.push_back(std::make_unique<Queue>());
+	}
+
+	threads_.reserve(threads);
+	for (std::size_t i = 0; i < threads; ++i) {
+		threads_.emplace_back([this, i] { worker_loop(i); });
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+
+	for (auto &thread: threads_) {
+		thread.join();
+	}
+}
+
+void ThreadPool::parallel_for(std::size_t count, const std::function<void(std::size_t)> &fn)
+{
+	if (count == 0) {
+		return;
+	}
+
+	Batch batch;
+	batch.fn = &fn;
+	batch.remaining.store(count, std::memory_order_relaxed);
+
+	// Distribute tasks round-robin so every worker starts with local work.
+	// A task is counted under its queue's lock, so queued_ never claims
+	// work a worker cannot find yet (which would keep it from sleeping)
+	for (std::size_t i = 0; i < count; ++i) {
+		auto &queue = *queues_[i % queues_.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(Task{&batch, i});
+		queued_.fetch_add(1, std::memory_order_release);
+	}
+
+	// Workers check queued_ under wake_mutex_; passing through it orders
+	// the increments before their next check, so no wakeup is lost
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex_);
+	}
+	wake_.notify_all();
+
+	// Help with the work instead of blocking; once nothing is left to steal,
+	// wait for the tasks still running on other threads
+	while (batch.remaining.load(std::memory_order_acquire) != 0) {
+		Task task;
+		if (try_pop(0, task)) {
+			run_task(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(batch.mutex);
+		batch.done.wait(lock, [&batch] {
+			return batch.remaining.load(std::memory_order_acquire) == 0;
+		});
+	}
+
+	// The last task decrements under the batch mutex; taking it here makes
+	// sure that task has let go of the batch before it leaves scope
+	std::lock_guard<std::mutex> lock(batch.mutex);
+	if (batch.error) {
+		std::rethrow_exception(batch.error);
+	}
+}
+
+bool ThreadPool::try_pop(std::size_t own, Task &task)
+{
+	const std::size_t count = queues_.size();
+
+	for (std::size_t i = 0; i < count; ++i) {
+		auto &queue = *queues_[(own + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.tasks.empty()) {
+			continue;
+		}
+
+		if (i == 0) {
+			// Own queue: LIFO keeps recently pushed work cache-hot
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		else {
+			// Steal the oldest task from a victim
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+
+		queued_.fetch_sub(1, std::memory_order_acq_rel);
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::run_task(const Task &task)
+{
+	Batch &batch = *task.batch;
+
+	std::exception_ptr error;
+	try {
+		(*batch.fn)(task.index);
+	} catch (...) {
+		error = std::current_exception();
+	}
+
+	// Decrement under the lock so the waiter can neither miss the
+	// notification nor destroy the batch while it is still in use here
+	std::lock_guard<std::mutex> lock(batch.mutex);
+	if (error && !batch.error) {
+		batch.error = error;
+	}
+	if (batch.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		batch.done.notify_all();
+	}
+}
+
+void ThreadPool::worker_loop(std::size_t id)
+{
+	for (;;) {
+		Task task;
+		if (try_pop(id, task)) {
+			run_task(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(wake_mutex_);
+		wake_.wait(lock, [this] {
+			return stop_ || queued_.load(std::memory_order_acquire) != 0;
+		});
+
+		if (stop_ && queued_.load(std::memory_order_acquire) == 0) {
+			return;
+		}
+	}
+}
+
+}// namespace kagome::common
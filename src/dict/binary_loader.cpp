@@ -209,6 +209,11 @@ std::shared_ptr<Dict> BinaryDictLoader::load_from_directory(const std::string &d
 		throw std::runtime_error("Failed to load dictionary: " + std::string(e.what()));
 	}
 
+	dict->resolve_feature_columns();
+	dict->classify_entries();
+	dict->intern_base_forms();
+	dict->build_ascii_category_ranges();
+
 	return dict;
 }
 
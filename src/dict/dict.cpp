@@ -1,11 +1,14 @@
 #include "kagome/dict/dict.hpp"
 #include "kagome/dict/binary_loader.hpp"
+#include "kagome/common/hash.hpp"
 #include <algorithm>
 #include <fmt/format.h>
 #include <fmt/core.h>
 #include <archive.h>
 #include <archive_entry.h>
 #include <sstream>
+#include <fstream>
+#include <stdexcept>
 #include <cstdlib>
 
 namespace kagome {
@@ -77,7 +80,7 @@ std::vector<std::pair<std::vector<int>, int>> IndexTable::common_prefix_search(c
 	return results;
 }
 
-void IndexTable::common_prefix_search_callback(const std::string &input,
+void IndexTable::common_prefix_search_callback(std::string_view input,
 											   std::function<void(int, int)> callback) const
 {
 	if (da.empty() || input.empty()) {
@@ -215,6 +218,11 @@ std::unique_ptr<Dict> DictLoader::load_from_zip(const std::string &zip_path, boo
 		return create_fallback_dict();
 	}
 
+	dict->resolve_feature_columns();
+	dict->classify_entries();
+	dict->intern_base_forms();
+	dict->build_ascii_category_ranges();
+
 	fmt::print("Successfully loaded dictionary from: {}\n", zip_path);
 	return dict;
 }
@@ -780,6 +788,11 @@ std::unique_ptr<Dict> DictLoader::create_fallback_dict()
 	dict->invoke_list = {true};
 	dict->group_list = {false};
 
+	dict->resolve_feature_columns();
+	dict->classify_entries();
+	dict->intern_base_forms();
+	dict->build_ascii_category_ranges();
+
 	auto info = std::make_unique<DictInfo>();
 	info->name = "Fallback Dictionary";
 	info->src = "Internal";
@@ -789,6 +802,245 @@ std::unique_ptr<Dict> DictLoader::create_fallback_dict()
 	return dict;
 }
 
+FeatureColumns FeatureColumns::resolve(const ankerl::unordered_dense::map<std::string, std::uint32_t> &meta)
+{
+	auto column = [&meta](const char *key) {
+		auto it = meta.find(std::string(key));
+		return it != meta.end() ? static_cast<std::int32_t>(it->second) : NO_COLUMN;
+	};
+
+	FeatureColumns columns;
+	columns.pos_start = column(POS_START_INDEX);
+	columns.pos_hierarchy = column(POS_HIERARCHY);
+	columns.inflectional_type = column(INFLECTIONAL_TYPE);
+	columns.inflectional_form = column(INFLECTIONAL_FORM);
+	columns.base_form = column(BASE_FORM_INDEX);
+	columns.reading = column(READING_INDEX);
+	columns.pronunciation = column(PRONUNCIATION_INDEX);
+
+	return columns;
+}
+
+void Dict::resolve_feature_columns()
+{
+	columns = FeatureColumns::resolve(contents_meta);
+	unk_dict.columns = FeatureColumns::resolve(unk_dict.contents_meta);
+}
+
+std::span<const PosFlagRule> default_pos_flag_rules()
+{
+	static const std::vector<PosFlagRule> rules = {
+		{{"記号"}, ENTRY_FLAG_PUNCTUATION},
+		{{"助詞"}, ENTRY_FLAG_STOP_WORD},
+		{{"助動詞"}, ENTRY_FLAG_STOP_WORD}};
+	return rules;
+}
+
+std::uint32_t StringPool::add(std::string_view str)
+{
+	auto id = static_cast<std::uint32_t>(size());
+	data_.append(str);
+	data_.push_back('\0');
+	offsets_.push_back(static_cast<std::uint32_t>(data_.size()));
+	return id;
+}
+
+std::optional<std::string_view> Dict::known_feature(std::int32_t id, std::size_t index) const
+{
+	// POS names come first, skipping IDs missing from the name list
+	std::size_t pos_count = 0;
+	if (static_cast<std::size_t>(id) < pos_table.pos_entries.size()) {
+		for (auto pos_id: pos_table.pos_entries[id]) {
+			if (pos_id < pos_table.name_list.size()) {
+				if (pos_count == index) {
+					return pos_table.name_list[pos_id];
+				}
+				++pos_count;
+			}
+		}
+	}
+
+	if (static_cast<std::size_t>(id) < contents.size()) {
+		const auto &content = contents[id];
+		if (index - pos_count < content.size()) {
+			return content[index - pos_count];
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::optional<std::string_view> Dict::unknown_feature(std::int32_t id, std::size_t index) const
+{
+	if (static_cast<std::size_t>(id) >= unk_dict.contents.size()) {
+		return std::nullopt;
+	}
+
+	const auto &content = unk_dict.contents[id];
+	if (index >= content.size()) {
+		return std::nullopt;
+	}
+	return content[index];
+}
+
+std::string_view Dict::entry_base_form(bool unknown, std::int32_t id) const
+{
+	auto feature = [this, unknown, id](std::size_t index) {
+		return unknown ? unknown_feature(id, index) : known_feature(id, index);
+	};
+
+	// Try metadata column first
+	std::int32_t column = unknown ? unk_dict.columns.base_form : columns.base_form;
+	if (column != FeatureColumns::NO_COLUMN) {
+		auto result = feature(static_cast<std::size_t>(column));
+		if (result && *result != "*") {
+			return *result;
+		}
+	}
+
+	// Fallback to direct index access for IPA dictionary format
+	// In IPA format: [0]=pos1, [1]=pos2, [2]=base_form, [3]=reading, [4]=pronunciation
+	return feature(2).value_or("*");
+}
+
+void Dict::intern_base_forms()
+{
+	base_form_pool.clear();
+	base_form_hashes.clear();
+
+	// Keys view the dictionary contents, which do not move while interning
+	ankerl::unordered_dense::map<std::string_view, std::uint32_t> interned;
+
+	auto intern = [this, &interned](std::string_view base_form) {
+		auto [it, inserted] = interned.try_emplace(base_form, 0);
+		if (inserted) {
+			it->second = base_form_pool.add(base_form);
+			base_form_hashes.push_back(common::hash_bytes(base_form));
+		}
+		return it->second;
+	};
+
+	base_form_ids.resize(morphs.size());
+	for (std::size_t id = 0; id < morphs.size(); ++id) {
+		base_form_ids[id] = intern(entry_base_form(false, static_cast<std::int32_t>(id)));
+	}
+
+	unk_dict.base_form_ids.resize(unk_dict.morphs.size());
+	for (std::size_t id = 0; id < unk_dict.morphs.size(); ++id) {
+		unk_dict.base_form_ids[id] = intern(entry_base_form(true, static_cast<std::int32_t>(id)));
+	}
+}
+
+void Dict::build_ascii_category_ranges()
+{
+	ascii_category_ranges = {};
+	std::array<std::size_t, 256> range_counts{};
+
+	for (std::uint32_t lo = 0; lo < 0x80;) {
+		auto category = static_cast<std::uint8_t>(character_category(lo));
+		std::uint32_t hi = lo;
+		while (hi + 1 < 0x80 &&
+			   static_cast<std::uint8_t>(character_category(hi + 1)) == category) {
+			++hi;
+		}
+
+		auto &set = ascii_category_ranges[category];
+		if (range_counts[category] < MAX_ASCII_CATEGORY_RANGES) {
+			set.ranges[range_counts[category]] = AsciiCategoryRanges::Range{static_cast<std::uint8_t>(lo),
+																			static_cast<std::uint8_t>(hi)};
+		}
+		++range_counts[category];
+		lo = hi + 1;
+	}
+
+	for (std::size_t category = 0; category < range_counts.size(); ++category) {
+		ascii_category_ranges[category].count = range_counts[category] <= MAX_ASCII_CATEGORY_RANGES
+													? static_cast<std::uint8_t>(range_counts[category])
+													: 0;
+	}
+}
+
+std::vector<std::string_view> Dict::known_pos(std::int32_t id) const
+{
+	std::vector<std::string_view> pos_names;
+
+	// Try POS table lookup first
+	if (static_cast<std::size_t>(id) < pos_table.pos_entries.size()) {
+		const auto &pos_ids = pos_table.pos_entries[id];
+		pos_names.reserve(pos_ids.size());
+
+		for (auto pos_id: pos_ids) {
+			if (pos_id < pos_table.name_list.size()) {
+				pos_names.push_back(pos_table.name_list[pos_id]);
+			}
+		}
+
+		if (!pos_names.empty()) {
+			return pos_names;
+		}
+	}
+
+	// Fallback to direct feature access for IPA dictionary format
+	// In IPA format: [0]=pos1, [1]=pos2, [2]=base_form, [3]=reading, [4]=pronunciation
+	if (static_cast<std::size_t>(id) < contents.size()) {
+		const auto &content = contents[id];
+		for (std::size_t i = 0; i < 2 && i < content.size(); ++i) {
+			if (content[i] != "*") {
+				pos_names.push_back(content[i]);
+			}
+		}
+	}
+
+	return pos_names;
+}
+
+std::vector<std::string_view> Dict::unknown_pos(std::int32_t id) const
+{
+	if (static_cast<std::size_t>(id) >= unk_dict.contents.size()) {
+		return {};
+	}
+
+	const auto &columns = unk_dict.columns;
+	std::size_t start = columns.pos_start != FeatureColumns::NO_COLUMN
+							? static_cast<std::size_t>(columns.pos_start)
+							: 0;
+	std::size_t hierarchy = columns.pos_hierarchy != FeatureColumns::NO_COLUMN
+								? static_cast<std::size_t>(columns.pos_hierarchy)
+								: 1;
+	std::size_t end = start + hierarchy;
+
+	const auto &feature = unk_dict.contents[id];
+	if (start >= end || end > feature.size()) {
+		return {};
+	}
+
+	return std::vector<std::string_view>(feature.begin() + start, feature.begin() + end);
+}
+
+void Dict::classify_entries(std::span<const PosFlagRule> rules)
+{
+	auto classify = [&rules](const std::vector<std::string_view> &pos) {
+		std::uint8_t flags = 0;
+		for (const auto &rule: rules) {
+			if (rule.pos_prefix.size() <= pos.size() &&
+				std::equal(rule.pos_prefix.begin(), rule.pos_prefix.end(), pos.begin())) {
+				flags |= rule.flags;
+			}
+		}
+		return flags;
+	};
+
+	entry_flags.assign(morphs.size(), 0);
+	for (std::size_t id = 0; id < morphs.size(); ++id) {
+		entry_flags[id] = classify(known_pos(static_cast<std::int32_t>(id)));
+	}
+
+	unk_dict.entry_flags.assign(unk_dict.morphs.size(), 0);
+	for (std::size_t id = 0; id < unk_dict.morphs.size(); ++id) {
+		unk_dict.entry_flags[id] = classify(unknown_pos(static_cast<std::int32_t>(id)));
+	}
+}
+
 void Dict::init_character_categories()
 {
 	// Initialize basic character categories
@@ -855,6 +1107,105 @@ std::shared_ptr<Dict> factory::create_ipa_dict()
 	return std::shared_ptr<Dict>(dict.release());
 }
 
+std::shared_ptr<UserDict> factory::load_user_dict(const std::string &filepath)
+{
+	std::ifstream file(filepath);
+	if (!file) {
+		throw std::runtime_error("Failed to open user dictionary: " + filepath);
+	}
+
+	// One entry per line: surface,segmentation,readings,pos where
+	// segmentation and readings are space separated; '#' starts a comment
+	std::vector<std::pair<std::string, UserEntry>> records;
+	std::string line;
+	std::size_t line_number = 0;
+
+	auto split = [](std::string_view str, char separator) {
+		std::vector<std::string> parts;
+		std::size_t start = 0;
+		while (start <= str.size()) {
+			auto end = str.find(separator, start);
+			if (end == std::string_view::npos) {
+				end = str.size();
+			}
+			if (end > start || separator == ',') {
+				parts.emplace_back(str.substr(start, end - start));
+			}
+			start = end + 1;
+		}
+		return parts;
+	};
+
+	while (std::getline(file, line)) {
+		++line_number;
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		auto fields = split(line, ',');
+		if (fields.size() != 4 || fields[0].empty()) {
+			throw std::runtime_error(fmt::format("Invalid user dictionary entry at {}:{}", filepath, line_number));
+		}
+
+		auto tokens = split(fields[1], ' ');
+		auto yomi = split(fields[2], ' ');
+		if (tokens.size() != yomi.size()) {
+			throw std::runtime_error(fmt::format("Segmentation and readings differ in length at {}:{}",
+												 filepath, line_number));
+		}
+
+		records.emplace_back(std::move(fields[0]), UserEntry(std::move(fields[3]), std::move(tokens), std::move(yomi)));
+	}
+
+	std::stable_sort(records.begin(), records.end(), [](const auto &a, const auto &b) {
+		return a.first < b.first;
+	});
+
+	auto user_dict = std::make_shared<UserDict>();
+	std::vector<std::string> surfaces;
+	surfaces.reserve(records.size());
+	user_dict->contents.reserve(records.size());
+
+	for (auto &[surface, entry]: records) {
+		if (!surfaces.empty() && surfaces.back() == surface) {
+			throw std::runtime_error(fmt::format("Duplicate user dictionary entry: {}", surface));
+		}
+		surfaces.push_back(std::move(surface));
+		user_dict->contents.push_back(std::move(entry));
+	}
+
+	user_dict->index.build(surfaces);
+	return user_dict;
+}
+
+// PrefixIndex implementation
+
+void PrefixIndex::build(const std::vector<std::string> &entries)
+{
+	root_ = std::make_unique<TrieNode>();
+	for (std::size_t id = 0; id < entries.size(); ++id) {
+		if (!entries[id].empty()) {
+			insert(entries[id], static_cast<std::int32_t>(id));
+		}
+	}
+}
+
+void PrefixIndex::insert(std::string_view str, std::int32_t id)
+{
+	TrieNode *current = root_.get();
+	for (char ch: str) {
+		auto &child = current->children[ch];
+		if (!child) {
+			child = std::make_unique<TrieNode>();
+		}
+		current = child.get();
+	}
+	current->entries.emplace_back(id, static_cast<std::int32_t>(str.length()));
+}
+
 // GobDecoder implementation
 
 bool GobDecoder::read_varint(uint64_t &value)
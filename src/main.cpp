@@ -115,6 +115,7 @@ void interactive_mode(kagome::tokenizer::Tokenizer &tokenizer,
 					  bool wakati_mode, bool json_mode)
 {
 	std::string line;
+	std::vector<std::string_view> surfaces;
 	std::cout << "Enter Japanese text (Ctrl+C to exit):\n";
 
 	while (std::getline(std::cin, line)) {
@@ -123,10 +124,10 @@ void interactive_mode(kagome::tokenizer::Tokenizer &tokenizer,
 		}
 
 		if (wakati_mode) {
-			auto wakati_results = tokenizer.wakati(line);
+			tokenizer.wakati(line, surfaces);
 			std::cout << "[";
 			bool first = true;
-			for (const auto &surface: wakati_results) {
+			for (const auto &surface: surfaces) {
 				if (!first) std::cout << " ";
 				first = false;
 				std::cout << surface;
@@ -0,0 +1,125 @@
+#include "kagome/tokenizer/chunker.hpp"
+#include <unicode/utf8.h>
+#include <algorithm>
+#include <limits>
+
+namespace kagome::tokenizer {
+
+namespace {
+
+bool is_ascii_space(unsigned char ch) noexcept
+{
+	return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\f' || ch == '\v';
+}
+
+}// namespace
+
+SentenceChunker::SentenceChunker(std::string_view input, std::size_t max_chunk_bytes)
+	: input_(input),
+	  max_chunk_bytes_(max_chunk_bytes == 0 ? std::numeric_limits<std::size_t>::max() : max_chunk_bytes)
+{
+}
+
+std::size_t SentenceChunker::terminator_length(std::size_t pos) const noexcept
+{
+	const auto *data = reinterpret_cast<const unsigned char *>(input_.data());
+	const std::size_t size = input_.size();
+
+	if (data[pos] == '\n') {
+		return 1;
+	}
+
+	if (pos + 2 >= size) {
+		return 0;
+	}
+
+	// 。 (U+3002)
+	if (data[pos] == 0xE3 && data[pos + 1] == 0x80 && data[pos + 2] == 0x82) {
+		return 3;
+	}
+
+	if (data[pos] == 0xEF) {
+		// ！ (U+FF01) and ？ (U+FF1F)
+		if (data[pos + 1] == 0xBC && (data[pos + 2] == 0x81 || data[pos + 2] == 0x9F)) {
+			return 3;
+		}
+		// ｡ (U+FF61, half-width ideographic full stop)
+		if (data[pos + 1] == 0xBD && data[pos + 2] == 0xA1) {
+			return 3;
+		}
+	}
+
+	return 0;
+}
+
+std::size_t SentenceChunker::forced_break(std::size_t begin, std::size_t limit) const noexcept
+{
+	const auto *data = reinterpret_cast<const unsigned char *>(input_.data());
+
+	// Prefer the last whitespace or ASCII/non-ASCII transition before the limit
+	for (std::size_t pos = limit; pos > begin; --pos) {
+		if (U8_IS_TRAIL(data[pos])) {
+			continue;
+		}
+
+		unsigned char prev = data[pos - 1];
+		if (is_ascii_space(prev) || (prev < 0x80) != (data[pos] < 0x80)) {
+			return pos;
+		}
+	}
+
+	// No natural break - cut at the last character boundary before the limit
+	std::size_t pos = limit;
+	while (pos > begin && U8_IS_TRAIL(data[pos])) {
+		--pos;
+	}
+
+	if (pos > begin) {
+		return pos;
+	}
+
+	// The limit is smaller than a single character; take the whole character
+	pos = limit;
+	while (pos < input_.size() && U8_IS_TRAIL(data[pos])) {
+		++pos;
+	}
+	return pos;
+}
+
+std::optional<Chunk> SentenceChunker::next()
+{
+	const std::size_t size = input_.size();
+	if (pos_ >= size) {
+		return std::nullopt;
+	}
+
+	const std::size_t begin = pos_;
+	const std::size_t limit = begin + std::min(max_chunk_bytes_, size - begin);
+	std::size_t end = 0;
+
+	for (std::size_t pos = begin; pos < limit; ++pos) {
+		std::size_t length = terminator_length(pos);
+		if (length == 0) {
+			continue;
+		}
+
+		// Keep runs of terminators (e.g. "！！" or blank lines) in one chunk,
+		// as long as the chunk stays within the size limit
+		end = pos + length;
+		while (end < size && (length = terminator_length(end)) != 0 &&
+			   end + length - begin <= max_chunk_bytes_) {
+			end += length;
+		}
+		break;
+	}
+
+	const bool forced = end == 0 && limit != size;
+	if (end == 0) {
+		end = forced ? forced_break(begin, limit) : size;
+	}
+
+	pos_ = end;
+	return Chunk{begin, input_.substr(begin, end - begin), forced};
+}
+
+}// namespace kagome::tokenizer
@@ -0,0 +1,130 @@
+#include "kagome/tokenizer/lattice/category_scanner.hpp"
+#include <unicode/utf8.h>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace kagome::tokenizer::lattice {
+
+std::size_t CategoryScanner::ascii_run_length(const dict::AsciiCategoryRanges &set,
+											  const char *data, std::size_t len) noexcept
+{
+	std::size_t pos = 0;
+
+	// A byte x is in [lo, hi] iff (x - lo) <= (hi - lo) as unsigned bytes;
+	// bytes >= 0x80 never match because all ranges lie below 0x80
+#if defined(__AVX2__)
+	for (; pos + 32 <= len; pos += 32) {
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+		__m256i match = _mm256_setzero_si256();
+
+		for (std::size_t i = 0; i < set.count; ++i) {
+			__m256i shifted = _mm256_sub_epi8(chunk, _mm256_set1_epi8(static_cast<char>(set.ranges[i].lo)));
+			__m256i width = _mm256_set1_epi8(static_cast<char>(set.ranges[i].hi - set.ranges[i].lo));
+			match = _mm256_or_si256(match, _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, width), shifted));
+		}
+
+		auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(match));
+		if (mask != 0xFFFFFFFFu) {
+			return pos + static_cast<std::size_t>(__builtin_ctz(~mask));
+		}
+	}
+#elif defined(__SSE2__)
+	for (; pos + 16 <= len; pos += 16) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+		__m128i match = _mm_setzero_si128();
+
+		for (std::size_t i = 0; i < set.count; ++i) {
+			__m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8(static_cast<char>(set.ranges[i].lo)));
+			__m128i width = _mm_set1_epi8(static_cast<char>(set.ranges[i].hi - set.ranges[i].lo));
+			match = _mm_or_si128(match, _mm_cmpeq_epi8(_mm_min_epu8(shifted, width), shifted));
+		}
+
+		auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(match));
+		if (mask != 0xFFFFu) {
+			return pos + static_cast<std::size_t>(__builtin_ctz(~mask));
+		}
+	}
+#endif
+
+	for (; pos < len; ++pos) {
+		auto byte = static_cast<std::uint8_t>(data[pos]);
+		bool in_set = false;
+		for (std::size_t i = 0; i < set.count; ++i) {
+			in_set |= byte >= set.ranges[i].lo && byte <= set.ranges[i].hi;
+		}
+		if (!in_set) {
+			break;
+		}
+	}
+
+	return pos;
+}
+
+std::int32_t CategoryScanner::scan(std::string_view input, std::int32_t &byte_pos,
+								   dict::CharacterCategory category, std::int32_t max_chars) const
+{
+	const auto *data = reinterpret_cast<const std::uint8_t *>(input.data());
+	const auto len = static_cast<std::int32_t>(input.size());
+	const auto &set = dict_->ascii_category_ranges[static_cast<std::uint8_t>(category)];
+	std::int32_t consumed = 0;
+
+	while (byte_pos < len && consumed < max_chars) {
+		const std::uint8_t lead = data[byte_pos];
+
+		if (lead < 0x80) {
+			if (set.count == 0) {
+				// Category has no (or too fragmented) ASCII ranges
+				if (dict_->character_category(lead) != category) {
+					break;
+				}
+				++byte_pos;
+				++consumed;
+				continue;
+			}
+
+			auto limit = static_cast<std::size_t>(std::min(len - byte_pos, max_chars - consumed));
+			auto run = static_cast<std::int32_t>(ascii_run_length(set, input.data() + byte_pos, limit));
+			byte_pos += run;
+			consumed += run;
+
+			// An ASCII byte outside the ranges ends the run; a non-ASCII one
+			// may still belong to the category (e.g. full-width letters)
+			if (byte_pos < len && consumed < max_chars && data[byte_pos] < 0x80) {
+				break;
+			}
+			continue;
+		}
+
+		UChar32 ch;
+		std::int32_t next = byte_pos;
+
+		if (lead >= 0xE0 && lead < 0xF0 && byte_pos + 2 < len &&
+			U8_IS_VALID_LEAD3_AND_T1(lead, data[byte_pos + 1]) && U8_IS_TRAIL(data[byte_pos + 2])) {
+			// Fast path for the 3-byte sequences of kana and kanji
+			ch = ((lead & 0x0F) << 12) | ((data[byte_pos + 1] & 0x3F) << 6) | (data[byte_pos + 2] & 0x3F);
+			next += 3;
+		}
+		else {
+			U8_NEXT(data, next, len, ch);
+			if (ch < 0) {
+				break;
+			}
+		}
+
+		if (dict_->character_category(static_cast<char32_t>(ch)) != category) {
+			break;
+		}
+
+		byte_pos = next;
+		++consumed;
+	}
+
+	return consumed;
+}
+
+}// namespace kagome::tokenizer::lattice
@@ -17,8 +17,8 @@ constexpr std::int32_t SEARCH_MODE_KANJI_PENALTY = 3000;
 constexpr std::int32_t SEARCH_MODE_OTHER_LENGTH = 7;
 constexpr std::int32_t SEARCH_MODE_OTHER_PENALTY = 1700;
 
-// Static memory pool
-ObjectPool<Node> Lattice::node_pool_;
+// Per-thread memory pool
+thread_local ObjectPool<Node> Lattice::node_pool_;
 
 // Helper function to count Unicode characters in UTF-8 string
 static std::int32_t count_utf8_chars(std::string_view str)
@@ -40,13 +40,14 @@ static std::int32_t count_utf8_chars(std::string_view str)
 
 Lattice::Lattice(std::shared_ptr<dict::Dict> dictionary,
 				 std::shared_ptr<dict::UserDict> user_dictionary)
-	: dict_(std::move(dictionary)), user_dict_(std::move(user_dictionary))
+	: dict_(std::move(dictionary)), user_dict_(std::move(user_dictionary)), scanner_(*dict_)
 {
 }
 
-void Lattice::build(std::string_view input)
+void Lattice::build(std::string_view input, LatticeMode mode)
 {
-	input_ = std::string(input);
+	input_ = input;
+	search_penalties_ = (mode != LatticeMode::Normal);
 
 	// Clear previous state
 	clear();
@@ -58,13 +59,14 @@ void Lattice::build(std::string_view input)
 	node_list_.resize(char_count + 2);
 
 	// Add BOS and EOS nodes
-	add_node(0, BOS_EOS_ID, 0, 0, NodeClass::Dummy, "");
+	add_node(0, BOS_EOS_ID, 0, 0, NodeClass::Dummy, "", 0);
 	add_node(char_count + 1, BOS_EOS_ID, static_cast<std::int32_t>(input.length()),
-			 char_count, NodeClass::Dummy, "");
+			 char_count, NodeClass::Dummy, "", 0);
 
 	// Process each character position
 	std::int32_t byte_pos = 0;
 	std::int32_t char_pos = 0;
+	std::int32_t chars_since_check = 0;
 
 	while (byte_pos < static_cast<std::int32_t>(input.length())) {
 		UChar32 current_char;
@@ -79,6 +81,13 @@ void Lattice::build(std::string_view input)
 			continue;
 		}
 
+		if (++chars_since_check == CLOCK_CHECK_CHARS) {
+			chars_since_check = 0;
+			if (deadline_passed()) {
+				return;
+			}
+		}
+
 		bool any_matches = false;
 		std::int32_t longest_match_bytes = 0;
 		std::int32_t longest_match_chars = 0;
@@ -91,17 +100,16 @@ void Lattice::build(std::string_view input)
 			user_dict_->index.common_prefix_search_callback(
 				remaining_input,
 				[this, char_pos, char_start_byte, &any_matches, &longest_match_bytes, &longest_match_chars](std::int32_t id, std::int32_t length) {
-					std::string surface(input_.substr(char_start_byte, length));
+					std::string_view surface = input_.substr(char_start_byte, length);
+					std::int32_t surface_chars = count_utf8_chars(surface);
 					add_node(char_pos, id, char_start_byte, char_pos,
-							 NodeClass::User, std::move(surface));
+							 NodeClass::User, surface, surface_chars);
 					any_matches = true;
 
 					// Track longest match
 					if (length > longest_match_bytes) {
 						longest_match_bytes = length;
-						// Count characters in this match
-						std::string_view match_surface(input_.data() + char_start_byte, length);
-						longest_match_chars = count_utf8_chars(match_surface);
+						longest_match_chars = surface_chars;
 					}
 				});
 		}
@@ -118,19 +126,18 @@ void Lattice::build(std::string_view input)
 										 input.length() - char_start_byte);
 
 		dict_->index.common_prefix_search_callback(
-			std::string(remaining_input),
+			remaining_input,
 			[this, char_pos, char_start_byte, &any_matches, &longest_match_bytes, &longest_match_chars](std::int32_t id, std::int32_t length) {
-				std::string surface(input_.substr(char_start_byte, length));
+				std::string_view surface = input_.substr(char_start_byte, length);
+				std::int32_t surface_chars = count_utf8_chars(surface);
 				add_node(char_pos, id, char_start_byte, char_pos,
-						 NodeClass::Known, std::move(surface));
+						 NodeClass::Known, surface, surface_chars);
 				any_matches = true;
 
 				// Track longest match
 				if (length > longest_match_bytes) {
 					longest_match_bytes = length;
-					// Count characters in this match
-					std::string_view match_surface(input_.data() + char_start_byte, length);
-					longest_match_chars = count_utf8_chars(match_surface);
+					longest_match_chars = surface_chars;
 				}
 			});
 
@@ -145,35 +152,22 @@ void Lattice::build(std::string_view input)
 		// 3. Handle unknown words (only if no dictionary matches found)
 		dict::CharacterCategory char_category = dict_->character_category(current_char);
 
-		std::int32_t end_byte = byte_pos;
-		std::int32_t unknown_word_len = 1;
-
 		// Group consecutive characters of same category if needed
-		if (dict_->should_group(char_category)) {
-			while (byte_pos < static_cast<std::int32_t>(input.length()) &&
-				   unknown_word_len < MAXIMUM_UNKNOWN_WORD_LENGTH) {
-				UChar32 next_char;
-				std::int32_t next_byte_pos = byte_pos;
-				U8_NEXT(reinterpret_cast<const uint8_t *>(input.data()), next_byte_pos,
-						static_cast<std::int32_t>(input.length()), next_char);
-
-				if (next_char < 0 || dict_->character_category(next_char) != char_category) {
-					break;
-				}
-
-				byte_pos = next_byte_pos;
-				end_byte = byte_pos;
-				unknown_word_len++;
-			}
-		}
+		std::int32_t unknown_word_len = group_unknown(input, byte_pos, char_category);
+		std::int32_t end_byte = byte_pos;
 
 		// Add unknown word entries
 		if (static_cast<std::size_t>(char_category) < dict_->unk_dict.index.size()) {
-			std::int32_t base_id = dict_->unk_dict.index[static_cast<std::size_t>(char_category)];
+			// Look up without operator[] - the dictionary is shared between threads
+			const auto &unk_index = dict_->unk_dict.index;
+			const auto &unk_index_dup = dict_->unk_dict.index_dup;
+			auto index_it = unk_index.find(static_cast<std::int32_t>(char_category));
+			std::int32_t base_id = index_it != unk_index.end() ? index_it->second : 0;
 			std::int32_t dup_count = 1;
 
-			if (static_cast<std::size_t>(char_category) < dict_->unk_dict.index_dup.size()) {
-				dup_count = dict_->unk_dict.index_dup[static_cast<std::size_t>(char_category)] + 1;
+			if (static_cast<std::size_t>(char_category) < unk_index_dup.size()) {
+				auto dup_it = unk_index_dup.find(static_cast<std::int32_t>(char_category));
+				dup_count = (dup_it != unk_index_dup.end() ? dup_it->second : 0) + 1;
 			}
 
 			for (std::int32_t i = 0; i < dup_count; ++i) {
@@ -186,23 +180,23 @@ void Lattice::build(std::string_view input)
 					U8_BACK_1(reinterpret_cast<const uint8_t *>(input.data()), 0, temp_pos);
 					truncated_end = temp_pos;
 
-					std::string truncated_surface = input_.substr(char_start_byte, truncated_end - char_start_byte);
+					std::string_view truncated_surface = input_.substr(char_start_byte, truncated_end - char_start_byte);
 					add_node(char_pos, base_id + i, char_start_byte, char_pos,
-							 NodeClass::Unknown, truncated_surface);
+							 NodeClass::Unknown, truncated_surface, unknown_word_len - 1);
 				}
 
 				// Add full word
-				std::string full_surface = input_.substr(char_start_byte, end_byte - char_start_byte);
+				std::string_view full_surface = input_.substr(char_start_byte, end_byte - char_start_byte);
 				add_node(char_pos, base_id + i, char_start_byte, char_pos,
-						 NodeClass::Unknown, std::move(full_surface));
+						 NodeClass::Unknown, full_surface, unknown_word_len);
 			}
 		}
 		else {
 			// Character category not in unk_dict - create basic unknown node to maintain lattice connectivity
 			// This is critical for mixed content (ASCII + Japanese) to work properly
-			std::string full_surface = input_.substr(char_start_byte, end_byte - char_start_byte);
-			add_node(char_pos, -2, char_start_byte, char_pos,// Use special ID for unmapped categories
-					 NodeClass::Unknown, std::move(full_surface));
+			std::string_view full_surface = input_.substr(char_start_byte, end_byte - char_start_byte);
+			add_node(char_pos, UNMAPPED_UNKNOWN_ID, char_start_byte, char_pos,
+					 NodeClass::Unknown, full_surface, unknown_word_len);
 		}
 
 		// Advance by the number of characters consumed by unknown word
@@ -211,8 +205,155 @@ void Lattice::build(std::string_view input)
 	}
 }
 
-void Lattice::add_node(std::int32_t pos, std::int32_t id, std::int32_t position,
-					   std::int32_t start, NodeClass node_class, std::string surface)
+void Lattice::build_plain(std::string_view input, LatticeMode mode)
+{
+	static_cast<void>(build_plain_impl(input, mode, false));
+}
+
+bool Lattice::try_build_plain(std::string_view input, LatticeMode mode)
+{
+	return build_plain_impl(input, mode, true);
+}
+
+bool Lattice::build_plain_impl(std::string_view input, LatticeMode mode, bool check_dictionary)
+{
+	input_ = input;
+	search_penalties_ = false;
+
+	clear();
+
+	// One list per unknown word holding its alternatives, between BOS and
+	// EOS: the only path build() leaves through the span
+	node_list_.emplace_back().push_back(new_node(BOS_EOS_ID, 0, 0, NodeClass::Dummy, ""));
+
+	std::int32_t byte_pos = 0;
+	std::int32_t char_pos = 0;
+	const auto input_len = static_cast<std::int32_t>(input.length());
+
+	while (byte_pos < input_len) {
+		UChar32 current_char;
+		std::int32_t char_start_byte = byte_pos;
+		U8_NEXT(reinterpret_cast<const uint8_t *>(input.data()), byte_pos, input_len, current_char);
+
+		if (current_char < 0) {
+			// Invalid UTF-8, skip
+			continue;
+		}
+
+		if (check_dictionary) {
+			// build() looks the dictionary up at the start of every word
+			bool matched = false;
+			dict_->index.common_prefix_search_callback(
+				input.substr(char_start_byte),
+				[&matched](std::int32_t, std::int32_t) { matched = true; });
+			if (matched) {
+				// The nodes so far go back to the pool on the next clear()
+				return false;
+			}
+		}
+
+		// Same grouping and IDs as the unknown word path of build()
+		dict::CharacterCategory char_category = dict_->character_category(current_char);
+		std::int32_t word_len = group_unknown(input, byte_pos, char_category);
+		std::string_view surface = input_.substr(char_start_byte, byte_pos - char_start_byte);
+		auto &alternatives = node_list_.emplace_back();
+
+		if (static_cast<std::size_t>(char_category) < dict_->unk_dict.index.size()) {
+			const auto &unk_index = dict_->unk_dict.index;
+			const auto &unk_index_dup = dict_->unk_dict.index_dup;
+			auto index_it = unk_index.find(static_cast<std::int32_t>(char_category));
+			std::int32_t base_id = index_it != unk_index.end() ? index_it->second : 0;
+			std::int32_t dup_count = 1;
+
+			if (static_cast<std::size_t>(char_category) < unk_index_dup.size()) {
+				auto dup_it = unk_index_dup.find(static_cast<std::int32_t>(char_category));
+				dup_count = (dup_it != unk_index_dup.end() ? dup_it->second : 0) + 1;
+			}
+
+			// build() also adds the word without its last character, but
+			// nothing continues from there, so it never is on the best path
+			for (std::int32_t i = 0; i < dup_count; ++i) {
+				alternatives.push_back(new_node(base_id + i, char_start_byte, char_pos,
+												NodeClass::Unknown, surface));
+			}
+		}
+		else {
+			alternatives.push_back(new_node(UNMAPPED_UNKNOWN_ID, char_start_byte, char_pos,
+											NodeClass::Unknown, surface));
+		}
+
+		char_pos += word_len;
+	}
+
+	node_list_.emplace_back().push_back(new_node(BOS_EOS_ID, input_len, char_pos, NodeClass::Dummy, ""));
+
+	// Viterbi over the chain, with the costs and tie-breaking of forward().
+	// Search penalties are left out: the alternatives of a word share its
+	// surface, so they would shift all of them alike.
+	for (std::size_t i = 1; i < node_list_.size(); ++i) {
+		const auto &prev_list = node_list_[i - 1];
+
+		for (Node *target: node_list_[i]) {
+			for (std::size_t k = 0; k < prev_list.size(); ++k) {
+				const Node *prev = prev_list[k];
+				std::int64_t total_cost = static_cast<std::int64_t>(dict_->connection.at(
+											  static_cast<std::size_t>(prev->right_id()),
+											  static_cast<std::size_t>(target->left_id()))) +
+										  static_cast<std::int64_t>(target->weight()) +
+										  static_cast<std::int64_t>(prev->cost());
+
+				if (total_cost > MAXIMUM_COST) {
+					total_cost = MAXIMUM_COST;
+				}
+
+				if (k == 0 || static_cast<std::int32_t>(total_cost) < target->cost()) {
+					target->set_cost(static_cast<std::int32_t>(total_cost));
+					target->set_prev(prev);
+				}
+			}
+		}
+	}
+
+	for (const Node *node = node_list_.back().front(); node; node = node->prev()) {
+		output_.push_back(const_cast<Node *>(node));
+	}
+	std::reverse(output_.begin(), output_.end());
+
+	if (mode == LatticeMode::Extended) {
+		// Extended mode: unigram unknown words, as backward() does
+		std::vector<Node *> words;
+		words.swap(output_);
+		output_.push_back(words.front());
+		for (std::size_t i = 1; i + 1 < words.size(); ++i) {
+			const Node *word = words[i];
+			std::int32_t char_byte = word->position();
+			const std::int32_t word_end = char_byte + static_cast<std::int32_t>(word->surface().size());
+			while (char_byte < word_end) {
+				std::int32_t next_byte = char_byte;
+				U8_FWD_1(reinterpret_cast<const uint8_t *>(input.data()), next_byte, word_end);
+				output_.push_back(new_node(word->id(), char_byte, char_byte, NodeClass::Dummy,
+										   input_.substr(char_byte, next_byte - char_byte)));
+				char_byte = next_byte;
+			}
+		}
+		output_.push_back(words.back());
+	}
+
+	return true;
+}
+
+std::int32_t Lattice::group_unknown(std::string_view input, std::int32_t &byte_pos,
+									dict::CharacterCategory category) const
+{
+	if (!dict_->should_group(category)) {
+		return 1;
+	}
+
+	return 1 + scanner_.scan(input, byte_pos, category, MAXIMUM_UNKNOWN_WORD_LENGTH - 1);
+}
+
+Node *Lattice::new_node(std::int32_t id, std::int32_t position, std::int32_t start,
+						NodeClass node_class, std::string_view surface)
 {
 	dict::Morph morph;
 
@@ -243,23 +384,62 @@ void Lattice::add_node(std::int32_t pos, std::int32_t id, std::int32_t position,
 	node->set_left_id(morph.left_id);
 	node->set_right_id(morph.right_id);
 	node->set_weight(morph.weight);
-	node->set_surface(std::move(surface));
+	node->set_surface(surface);
 	node->set_prev(nullptr);
+	node->set_penalty(0);
+
+	return node;
+}
+
+void Lattice::add_node(std::int32_t pos, std::int32_t id, std::int32_t position,
+					   std::int32_t start, NodeClass node_class, std::string_view surface,
+					   std::int32_t char_count)
+{
+	Node *node = new_node(id, position, start, node_class, surface);
 
-	// Calculate target position
-	std::int32_t target_pos = pos;
-	if (!node->surface().empty()) {
-		// Count characters in surface using optimized function
-		std::int32_t char_count = count_utf8_chars(node->surface());
-		target_pos = pos + char_count;
+	// Precompute the search penalty once instead of per edge in forward()
+	if (search_penalties_) {
+		node->set_penalty(search_penalty(node->surface(), char_count));
 	}
 
+	std::int32_t target_pos = pos + char_count;
 	if (target_pos < static_cast<std::int32_t>(node_list_.size())) {
 		node_list_[target_pos].push_back(node);
 	}
 }
 
 void Lattice::forward(LatticeMode mode)
+{
+	switch (mode) {
+	case LatticeMode::Normal:
+		forward<LatticeMode::Normal>();
+		break;
+	case LatticeMode::Search:
+		forward<LatticeMode::Search>();
+		break;
+	case LatticeMode::Extended:
+		forward<LatticeMode::Extended>();
+		break;
+	}
+}
+
+void Lattice::backward(LatticeMode mode)
+{
+	switch (mode) {
+	case LatticeMode::Normal:
+		backward<LatticeMode::Normal>();
+		break;
+	case LatticeMode::Search:
+		backward<LatticeMode::Search>();
+		break;
+	case LatticeMode::Extended:
+		backward<LatticeMode::Extended>();
+		break;
+	}
+}
+
+template<LatticeMode Mode>
+void Lattice::forward()
 {
 	for (std::size_t i = 1; i < node_list_.size(); ++i) {
 		auto &current_list = node_list_[i];
@@ -278,7 +458,24 @@ void Lattice::forward(LatticeMode mode)
 				continue;
 			}
 
-			for (std::size_t k = 0; k < prev_list.size(); ++k) {
+			// With a beam, prev_list was ordered when its position was done
+			const std::size_t prev_count = beam_width_ == 0
+											   ? prev_list.size()
+											   : std::min(prev_list.size(), beam_width_);
+
+			edges_ += prev_count;
+			if (max_edges_ != 0 && edges_ > max_edges_) {
+				budget_exceeded_ = true;
+				return;
+			}
+			if (edges_ >= next_clock_check_) {
+				next_clock_check_ = edges_ + CLOCK_CHECK_EDGES;
+				if (deadline_passed()) {
+					return;
+				}
+			}
+
+			for (std::size_t k = 0; k < prev_count; ++k) {
 				const Node *prev = prev_list[k];
 
 				// Calculate connection cost
@@ -294,9 +491,9 @@ void Lattice::forward(LatticeMode mode)
 										  static_cast<std::int64_t>(target->weight()) +
 										  static_cast<std::int64_t>(prev->cost());
 
-				// Add search mode penalty
-				if (mode != LatticeMode::Normal) {
-					total_cost += additional_cost(prev);
+				// Add search mode penalty (precomputed in build)
+				if constexpr (Mode != LatticeMode::Normal) {
+					total_cost += prev->penalty();
 				}
 
 				// Clamp to maximum
@@ -311,10 +508,28 @@ void Lattice::forward(LatticeMode mode)
 				}
 			}
 		}
+
+		// Move the cheapest paths ending here to the front for the positions
+		// that continue from this one. Nodes are only reordered, never
+		// dropped, so clear() still returns all of them to the pool.
+		if (beam_width_ != 0 && current_list.size() > beam_width_ && i + 1 < node_list_.size()) {
+			auto path_cost = [](const Node *node) {
+				std::int64_t cost = node->cost();
+				if constexpr (Mode != LatticeMode::Normal) {
+					cost += node->penalty();
+				}
+				return cost;
+			};
+			std::nth_element(current_list.begin(),
+							 current_list.begin() + static_cast<std::ptrdiff_t>(beam_width_ - 1),
+							 current_list.end(),
+							 [&](const Node *a, const Node *b) { return path_cost(a) < path_cost(b); });
+		}
 	}
 }
 
-void Lattice::backward(LatticeMode mode)
+template<LatticeMode Mode>
+void Lattice::backward()
 {
 	output_.clear();
 
@@ -327,12 +542,15 @@ void Lattice::backward(LatticeMode mode)
 	const Node *current = node_list_.back()[0];
 
 	while (current != nullptr) {
-		if (mode != LatticeMode::Extended || current->node_class() != NodeClass::Unknown) {
+		if constexpr (Mode != LatticeMode::Extended) {
+			collected_nodes.push_back(const_cast<Node *>(current));
+		}
+		else if (current->node_class() != NodeClass::Unknown) {
 			collected_nodes.push_back(const_cast<Node *>(current));
 		}
 		else {
 			// Extended mode: break unknown words into characters
-			const std::string &surface = current->surface();
+			std::string_view surface = current->surface();
 			std::vector<Node *> char_nodes;
 
 			// Iterate directly over UTF-8 string without conversion
@@ -358,8 +576,9 @@ void Lattice::backward(LatticeMode mode)
 				}
 			}
 
-			// Add character nodes in forward order
-			for (auto it = char_nodes.begin(); it != char_nodes.end(); ++it) {
+			// Add character nodes backwards like the path, so that the
+			// final reversal puts them in forward order
+			for (auto it = char_nodes.rbegin(); it != char_nodes.rend(); ++it) {
 				collected_nodes.push_back(*it);
 			}
 		}
@@ -374,6 +593,13 @@ void Lattice::backward(LatticeMode mode)
 	}
 }
 
+template void Lattice::forward<LatticeMode::Normal>();
+template void Lattice::forward<LatticeMode::Search>();
+template void Lattice::forward<LatticeMode::Extended>();
+template void Lattice::backward<LatticeMode::Normal>();
+template void Lattice::backward<LatticeMode::Search>();
+template void Lattice::backward<LatticeMode::Extended>();
+
 void Lattice::export_dot(std::ostream &output) const
 {
 	// Create set of best path nodes for highlighting
@@ -424,7 +650,7 @@ void Lattice::export_dot(std::ostream &output) const
 				continue;
 			}
 
-			std::string surface = node->surface();
+			std::string surface(node->surface());
 			if (node->is_bos_eos()) {
 				surface = (i == 0) ? "BOS" : "EOS";
 			}
@@ -516,16 +742,13 @@ std::string Lattice::to_string() const
 	return result;
 }
 
-std::int32_t Lattice::additional_cost(const Node *node) const
+std::int32_t Lattice::search_penalty(std::string_view surface, std::int32_t char_count) const
 {
-	if (!node || node->surface().empty()) {
+	if (surface.empty()) {
 		return 0;
 	}
 
-	// Count Unicode characters using optimized function
-	std::int32_t char_count = count_utf8_chars(node->surface());
-
-	if (char_count > SEARCH_MODE_KANJI_LENGTH && is_kanji_only(node->surface())) {
+	if (char_count > SEARCH_MODE_KANJI_LENGTH && is_kanji_only(surface)) {
 		return (char_count - SEARCH_MODE_KANJI_LENGTH) * SEARCH_MODE_KANJI_PENALTY;
 	}
 
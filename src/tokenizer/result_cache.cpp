@@ -0,0 +1,156 @@
+#include "kagome/tokenizer/result_cache.hpp"
+#include "kagome/common/hash.hpp"
+
+namespace kagome::tokenizer {
+
+ResultCache::ResultCache(std::size_t max_bytes)
+	: max_bytes_(max_bytes)
+{
+}
+
+std::uint64_t ResultCache::hash(std::string_view input, std::uint32_t tag) noexcept
+{
+	// The tag is mixed in with a multiplicative constant so equal texts
+	// under different tags differ
+	return common::hash_bytes(input) ^
+		   (static_cast<std::uint64_t>(tag) * 0x9E3779B97F4A7C15ull);
+}
+
+bool ResultCache::find(std::string_view input, const dict::Dict *dict,
+					   const dict::UserDict *user_dict, std::vector<TokenView> &tokens,
+					   std::uint32_t tag, bool *degraded)
+{
+	const std::uint64_t key = hash(input, tag);
+	std::shared_ptr<const Entry> entry;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = index_.find(key);
+		// Compare the content too: a hash collision must never hand out the
+		// offsets of another text
+		if (it == index_.end() || slots_[it->second].entry->tag != tag ||
+			slots_[it->second].entry->input != input) {
+			++stats_.misses;
+			return false;
+		}
+
+		auto &slot = slots_[it->second];
+		slot.referenced = true;
+		entry = slot.entry;
+		++stats_.hits;
+	}
+
+	// Rebuild the views outside the lock; the entry stays alive through
+	// our reference even if it is evicted meanwhile
+	tokens.clear();
+	tokens.reserve(entry->tokens.size());
+	std::int32_t index = 0;
+	for (const auto &token: entry->tokens) {
+		tokens.emplace_back(index++, token.id, token.token_class, token.start, token.end,
+							input.substr(static_cast<std::size_t>(token.start),
+										 static_cast<std::size_t>(token.end - token.start)),
+							dict, user_dict);
+	}
+	if (degraded) {
+		*degraded = entry->degraded;
+	}
+	return true;
+}
+
+void ResultCache::insert(std::string_view input, std::span<const TokenView> tokens, std::uint32_t tag,
+						 bool degraded)
+{
+	const std::size_t bytes = sizeof(Entry) + input.size() + tokens.size() * sizeof(CachedToken);
+	if (max_bytes_ == 0 || bytes > max_bytes_ / MAX_ENTRY_FRACTION) {
+		return;
+	}
+	for (const auto &token: tokens) {
+		if (token.rewritten()) {
+			return;
+		}
+	}
+
+	auto entry = std::make_shared<Entry>();
+	entry->tag = tag;
+	entry->degraded = degraded;
+	entry->input.assign(input);
+	entry->tokens.reserve(tokens.size());
+	for (const auto &token: tokens) {
+		entry->tokens.push_back(CachedToken{token.id(), token.start(), token.end(), token.token_class()});
+	}
+
+	const std::uint64_t key = hash(input, tag);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (auto it = index_.find(key); it != index_.end()) {
+		release(it->second);
+	}
+	make_room(bytes);
+
+	std::size_t slot;
+	if (!free_slots_.empty()) {
+		slot = free_slots_.back();
+		free_slots_.pop_back();
+	}
+	else {
+		slot = slots_.size();
+		slots_.emplace_back();
+	}
+
+	slots_[slot] = Slot{key, std::move(entry), bytes, false};
+	index_.emplace(key, slot);
+	stats_.bytes += bytes;
+	++stats_.entries;
+	++stats_.insertions;
+}
+
+void ResultCache::make_room(std::size_t bytes)
+{
+	// Every full sweep clears all reference bits, so the second one evicts
+	while (stats_.bytes + bytes > max_bytes_ && stats_.entries > 0) {
+		if (hand_ >= slots_.size()) {
+			hand_ = 0;
+		}
+
+		auto &slot = slots_[hand_];
+		if (slot.entry) {
+			if (slot.referenced) {
+				slot.referenced = false;
+			}
+			else {
+				release(hand_);
+				++stats_.evictions;
+			}
+		}
+		++hand_;
+	}
+}
+
+void ResultCache::release(std::size_t slot)
+{
+	auto &victim = slots_[slot];
+	index_.erase(victim.hash);
+	stats_.bytes -= victim.bytes;
+	--stats_.entries;
+	victim = Slot{};
+	free_slots_.push_back(slot);
+}
+
+void ResultCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	slots_.clear();
+	free_slots_.clear();
+	index_.clear();
+	hand_ = 0;
+	stats_.entries = 0;
+	stats_.bytes = 0;
+}
+
+ResultCache::Stats ResultCache::stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stats_;
+}
+
+}// namespace kagome::tokenizer
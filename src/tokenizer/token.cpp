@@ -2,6 +2,7 @@
 #include <unicode/ustring.h>
 #include <unicode/utf8.h>
 #include "kagome/common/format.hpp"
+#include "kagome/common/hash.hpp"
 #include <algorithm>
 
 namespace kagome::tokenizer {
@@ -39,7 +40,15 @@ Token::Token(std::string surface, std::int32_t id, std::int32_t start,
 	}
 }
 
-std::vector<std::string> Token::features() const
+Token::Token(const TokenView &view, std::shared_ptr<dict::Dict> dict,
+			 std::shared_ptr<dict::UserDict> user_dict)
+	: index_(view.index()), id_(view.id()), class_(view.token_class()), position_(view.start()),
+	  start_(view.start()), end_(view.end()), surface_(view.surface()),
+	  dict_(std::move(dict)), user_dict_(std::move(user_dict))
+{
+}
+
+std::vector<std::string> TokenView::features() const
 {
 	switch (class_) {
 	case TokenClass::Known: {
@@ -111,85 +120,77 @@ std::vector<std::string> Token::features() const
 	}
 }
 
-std::optional<std::string> Token::feature_at(std::size_t index) const
+std::optional<std::string> TokenView::feature_at(std::size_t index) const
 {
-	const auto features = this->features();
-	if (index >= features.size()) {
+	if (class_ == TokenClass::User) {
+		// User features are joined on the fly and have no in-place storage
+		const auto features = this->features();
+		if (index >= features.size()) {
+			return std::nullopt;
+		}
+		return features[index];
+	}
+
+	auto feature = feature_view(index);
+	if (!feature) {
 		return std::nullopt;
 	}
-	return features[index];
+	return std::string(*feature);
 }
 
-std::vector<std::string> Token::pos() const
+std::optional<std::string_view> TokenView::feature_view(std::size_t index) const
 {
 	switch (class_) {
-	case TokenClass::Known: {
-		// Try POS table lookup first
-		if (dict_ && static_cast<std::size_t>(id_) < dict_->pos_table.pos_entries.size()) {
-			const auto &pos_ids = dict_->pos_table.pos_entries[id_];
-			std::vector<std::string> pos_names;
-			pos_names.reserve(pos_ids.size());
+	case TokenClass::Known:
+		return dict_ ? dict_->known_feature(id_, index) : std::nullopt;
 
-			for (auto pos_id: pos_ids) {
-				if (pos_id < dict_->pos_table.name_list.size()) {
-					pos_names.push_back(dict_->pos_table.name_list[pos_id]);
-				}
-			}
+	case TokenClass::Unknown:
+		return dict_ ? dict_->unknown_feature(id_, index) : std::nullopt;
 
-			if (!pos_names.empty()) {
-				return pos_names;
-			}
+	case TokenClass::User: {
+		if (!user_dict_ || static_cast<std::size_t>(id_) >= user_dict_->contents.size()) {
+			return std::nullopt;
 		}
 
-		// Fallback to direct feature access for IPA dictionary format
-		// In IPA format: [0]=pos1, [1]=pos2, [2]=base_form, [3]=reading, [4]=pronunciation
-		std::vector<std::string> pos_features;
-		auto pos1 = feature_at(0);
-		auto pos2 = feature_at(1);
-
-		if (pos1 && *pos1 != "*") {
-			pos_features.push_back(*pos1);
-		}
-		if (pos2 && *pos2 != "*") {
-			pos_features.push_back(*pos2);
+		const auto &entry = user_dict_->contents[id_];
+		if (index == 0) {
+			return entry.pos;
 		}
 
-		return pos_features;
+		// Same layout as features(); only single-part fields exist unjoined
+		std::size_t field = 1;
+		for (const auto *parts: {&entry.tokens, &entry.yomi}) {
+			if (parts->empty()) {
+				continue;
+			}
+			if (field == index) {
+				return parts->size() == 1 ? std::optional<std::string_view>((*parts)[0]) : std::nullopt;
+			}
+			++field;
+		}
+		return std::nullopt;
 	}
 
-	case TokenClass::Unknown: {
-		if (!dict_) return {};
-
-		auto start_it = dict_->unk_dict.contents_meta.find(
-			std::string(dict::POS_START_INDEX));
-		auto hierarchy_it = dict_->unk_dict.contents_meta.find(
-			std::string(dict::POS_HIERARCHY));
-
-		std::size_t start = (start_it != dict_->unk_dict.contents_meta.end())
-								? start_it->second
-								: 0;
-		std::size_t hierarchy = (hierarchy_it != dict_->unk_dict.contents_meta.end())
-									? hierarchy_it->second
-									: 1;
-		std::size_t end = start + hierarchy;
-
-		if (static_cast<std::size_t>(id_) >= dict_->unk_dict.contents.size()) {
-			return {};
-		}
+	case TokenClass::Dummy:
+	default:
+		return std::nullopt;
+	}
+}
 
-		const auto &feature = dict_->unk_dict.contents[id_];
-		if (start >= end || end > feature.size()) {
-			return {};
-		}
+std::vector<std::string> TokenView::pos() const
+{
+	auto views = pos_view();
+	return std::vector<std::string>(views.begin(), views.end());
+}
 
-		std::vector<std::string> pos_features;
-		pos_features.reserve(end - start);
-		for (std::size_t i = start; i < end; ++i) {
-			pos_features.push_back(feature[i]);
-		}
+std::vector<std::string_view> TokenView::pos_view() const
+{
+	switch (class_) {
+	case TokenClass::Known:
+		return dict_ ? dict_->known_pos(id_) : std::vector<std::string_view>{};
 
-		return pos_features;
-	}
+	case TokenClass::Unknown:
+		return dict_ ? dict_->unknown_pos(id_) : std::vector<std::string_view>{};
 
 	case TokenClass::User: {
 		if (!user_dict_ || static_cast<std::size_t>(id_) >= user_dict_->contents.size()) {
@@ -205,19 +206,19 @@ std::vector<std::string> Token::pos() const
 	}
 }
 
-std::optional<std::string> Token::pickup_from_features(std::string_view key) const
+std::optional<std::string_view> TokenView::pickup_from_features(std::int32_t dict::FeatureColumns::*column) const
 {
-	ankerl::unordered_dense::map<std::string, std::uint32_t> *meta = nullptr;
+	std::int32_t index = dict::FeatureColumns::NO_COLUMN;
 
 	switch (class_) {
 	case TokenClass::Known:
 		if (dict_) {
-			meta = &dict_->contents_meta;
+			index = dict_->columns.*column;
 		}
 		break;
 	case TokenClass::Unknown:
 		if (dict_) {
-			meta = &dict_->unk_dict.contents_meta;
+			index = dict_->unk_dict.columns.*column;
 		}
 		break;
 	case TokenClass::Dummy:
@@ -226,69 +227,117 @@ std::optional<std::string> Token::pickup_from_features(std::string_view key) con
 		return std::nullopt;
 	}
 
-	if (!meta) return std::nullopt;
-
-	auto it = meta->find(std::string(key));
-	if (it == meta->end()) {
+	if (index == dict::FeatureColumns::NO_COLUMN) {
 		return std::nullopt;
 	}
 
-	return feature_at(static_cast<std::size_t>(it->second));
+	return feature_view(static_cast<std::size_t>(index));
 }
 
-std::string Token::inflectional_type() const
+std::string_view TokenView::feature_or_fallback(std::int32_t dict::FeatureColumns::*column,
+												std::size_t fallback_index) const
 {
-	auto result = pickup_from_features(dict::INFLECTIONAL_TYPE);
-	return result.value_or("*");
+	// Try metadata column first
+	auto result = pickup_from_features(column);
+	if (result && *result != "*") {
+		return *result;
+	}
+
+	// Fallback to direct index access for IPA dictionary format
+	// In IPA format: [0]=pos1, [1]=pos2, [2]=base_form, [3]=reading, [4]=pronunciation
+	return feature_view(fallback_index).value_or("*");
 }
 
-std::string Token::inflectional_form() const
+std::string TokenView::inflectional_type() const
 {
-	auto result = pickup_from_features(dict::INFLECTIONAL_FORM);
-	return result.value_or("*");
+	return std::string(pickup_from_features(&dict::FeatureColumns::inflectional_type).value_or("*"));
 }
 
-std::string Token::base_form() const
+std::string TokenView::inflectional_form() const
 {
-	// Try metadata lookup first
-	auto result = pickup_from_features(dict::BASE_FORM_INDEX);
-	if (result && *result != "*") {
-		return *result;
+	return std::string(pickup_from_features(&dict::FeatureColumns::inflectional_form).value_or("*"));
+}
+
+std::string_view TokenView::base_form_view() const
+{
+	// Interned base forms are resolved once at load time
+	if (dict_ && class_ == TokenClass::Known) {
+		if (auto base_form = dict_->known_base_form(id_)) {
+			return *base_form;
+		}
 	}
+	else if (dict_ && class_ == TokenClass::Unknown) {
+		if (auto base_form = dict_->unknown_base_form(id_)) {
+			return *base_form;
+		}
+	}
+	return feature_or_fallback(&dict::FeatureColumns::base_form, 2);
+}
 
-	// Fallback to direct index access for IPA dictionary format
-	// In IPA format: [0]=pos1, [1]=pos2, [2]=base_form, [3]=reading, [4]=pronunciation
-	auto feature = feature_at(2);
-	return feature.value_or("*");
+std::string_view TokenView::normalized_view() const
+{
+	std::string_view base_form = base_form_view();
+	if (base_form.empty() || base_form == "*") {
+		return normalized_surface();
+	}
+	return base_form;
 }
 
-std::string Token::reading() const
+std::uint64_t TokenView::normalized_hash() const
 {
-	// Try metadata lookup first
-	auto result = pickup_from_features(dict::READING_INDEX);
-	if (result && *result != "*") {
-		return *result;
+	std::string_view base_form = base_form_view();
+	if (base_form.empty() || base_form == "*") {
+		return common::hash_bytes(normalized_surface());
 	}
 
-	// Fallback to direct index access for IPA dictionary format
-	auto feature = feature_at(3);
-	return feature.value_or("*");
+	std::optional<std::uint64_t> hash;
+	if (dict_ && class_ == TokenClass::Known) {
+		hash = dict_->known_base_form_hash(id_);
+	}
+	else if (dict_ && class_ == TokenClass::Unknown) {
+		hash = dict_->unknown_base_form_hash(id_);
+	}
+	return hash ? *hash : common::hash_bytes(base_form);
 }
 
-std::string Token::pronunciation() const
+std::string_view TokenView::reading_view() const
 {
-	// Try metadata lookup first
-	auto result = pickup_from_features(dict::PRONUNCIATION_INDEX);
-	if (result && *result != "*") {
-		return *result;
+	return feature_or_fallback(&dict::FeatureColumns::reading, 3);
+}
+
+std::string_view TokenView::pronunciation_view() const
+{
+	return feature_or_fallback(&dict::FeatureColumns::pronunciation, 4);
+}
+
+std::string TokenView::base_form() const
+{
+	if (class_ == TokenClass::User) {
+		// Joined user features cannot be viewed in place
+		return feature_at(2).value_or("*");
 	}
+	return std::string(base_form_view());
+}
 
-	// Fallback to direct index access for IPA dictionary format
-	auto feature = feature_at(4);
-	return feature.value_or("*");
+std::string TokenView::reading() const
+{
+	if (class_ == TokenClass::User) {
+		// Joined user features cannot be viewed in place
+		return feature_at(3).value_or("*");
+	}
+	return std::string(reading_view());
+}
+
+std::string TokenView::pronunciation() const
+{
+	if (class_ == TokenClass::User) {
+		// Joined user features cannot be viewed in place
+		return feature_at(4).value_or("*");
+	}
+	return std::string(pronunciation_view());
 }
 
-std::optional<UserExtra> Token::user_extra() const
+std::optional<UserExtra> TokenView::user_extra() const
 {
 	if (class_ != TokenClass::User || !user_dict_ ||
 		static_cast<std::size_t>(id_) >= user_dict_->contents.size()) {
@@ -309,13 +358,13 @@ bool Token::equal_pos(const Token &other) const
 	return utils::equal_features(this->pos(), other.pos());
 }
 
-TokenData Token::to_token_data() const
+TokenData TokenView::to_token_data() const
 {
 	TokenData data;
 	data.id = id_;
 	data.start = start_;
 	data.end = end_;
-	data.surface = surface_;
+	data.surface = std::string(surface_);
 	data.token_class = std::string(kagome::tokenizer::to_string(class_));
 	data.pos = pos();
 	data.features = features();
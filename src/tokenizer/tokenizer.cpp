@@ -1,5 +1,7 @@
 #include "kagome/tokenizer/tokenizer.hpp"
 #include "kagome/tokenizer/lattice/lattice.hpp"
+#include "kagome/common/utf8.hpp"
+#include "kagome/common/normalize.hpp"
 #include <unicode/utf8.h>
 #include <unicode/ustring.h>
 #include <algorithm>
@@ -9,6 +11,48 @@
 
 namespace kagome::tokenizer {
 
+namespace {
+
+/// A token of normalized text rebuilt over the bytes of input it came from;
+/// its normalized surface keeps viewing the normalized text if they differ
+TokenView restore_original(const TokenView &token, const common::NormalizedText &normalized,
+						   std::string_view input)
+{
+	const std::int32_t start = normalized.original_start(token.start());
+	const std::int32_t end = token.end() == token.start() ? start : normalized.original_end(token.end());
+	TokenView restored(token.index(), token.id(), token.token_class(), start, end,
+					   input.substr(static_cast<std::size_t>(start), static_cast<std::size_t>(end - start)),
+					   token.dict(), token.user_dict());
+	if (restored.surface() != token.surface()) {
+		restored.set_normalized_surface(token.surface());
+	}
+	return restored;
+}
+
+template<lattice::LatticeMode Mode>
+void run_lattice_passes(lattice::Lattice &lattice, std::string_view input)
+{
+	// Build lattice from input, unless an earlier segment used up the budget
+	if (!lattice.budget_exceeded()) {
+		lattice.build(input, Mode);
+	}
+
+	// Forward pass (Viterbi algorithm)
+	if (!lattice.budget_exceeded()) {
+		lattice.forward<Mode>();
+	}
+
+	// Out of budget: segment by character class instead
+	if (lattice.budget_exceeded()) {
+		lattice.build_plain(input, Mode);
+		return;
+	}
+
+	lattice.backward<Mode>();
+}
+
+}// namespace
+
 Tokenizer::Tokenizer(std::unique_ptr<dict::Dict> dictionary)
 	: dict_(std::move(dictionary)), config_{}
 {
@@ -24,118 +68,550 @@ void Tokenizer::set_mode(TokenizerType type)
 	config_.default_mode = static_cast<TokenizeMode>(type);
 }
 
-std::vector<Token> Tokenizer::tokenize(std::string_view input) const
+void Tokenizer::set_user_dict(std::shared_ptr<dict::UserDict> user_dictionary)
+{
+	user_dict_ = std::move(user_dictionary);
+}
+
+void Tokenizer::set_chunk_cache(std::shared_ptr<ResultCache> cache)
+{
+	chunk_cache_ = std::move(cache);
+}
+
+std::vector<Token> Tokenizer::tokenize(std::string_view input, bool *degraded) const
 {
-	return analyze(input, config_.default_mode);
+	return analyze(input, config_.default_mode, degraded);
 }
 
-std::vector<Token> Tokenizer::analyze(std::string_view input, TokenizeMode mode) const
+std::vector<Token> Tokenizer::analyze(std::string_view input, TokenizeMode mode, bool *degraded) const
 {
-	return analyze_impl(input, mode, nullptr);
+	return analyze_impl(input, mode, nullptr, degraded);
 }
 
 std::vector<std::string> Tokenizer::wakati(std::string_view input) const
 {
-	auto tokens = analyze(input, TokenizeMode::Normal);
-	std::vector<std::string> result;
-	result.reserve(tokens.size());
+	std::vector<std::string_view> surfaces;
+	wakati(input, surfaces);
+	return {surfaces.begin(), surfaces.end()};
+}
 
-	for (const auto &token: tokens) {
-		// Accept tokens with valid surface text, even if classified as Dummy
-		// This is a workaround for the dictionary reference issue in lattice processing
-		if (!token.surface().empty()) {
-			result.push_back(token.surface());
-		}
+void Tokenizer::wakati(std::string_view input, std::vector<std::string_view> &surfaces) const
+{
+	surfaces.clear();
+	if (!get_dict()) {
+		return;
 	}
 
-	return result;
+	auto lattice = create_lattice();
+	wakati(*lattice, input, surfaces);
+}
+
+void Tokenizer::wakati(lattice::Lattice &lattice, std::string_view input,
+					   std::vector<std::string_view> &surfaces) const
+{
+	surfaces.clear();
+	if (!get_dict()) {
+		return;
+	}
+
+	std::int32_t index = 0;
+	start_budget(lattice);
+	analyze_document(lattice, input, TokenizeMode::Normal, index, [&surfaces](const TokenView &token) {
+		// Accept tokens with valid surface text, even if classified as Dummy;
+		// only BOS/EOS are empty
+		if (!token.surface().empty()) {
+			surfaces.push_back(token.surface());
+		}
+	});
 }
 
 std::vector<Token> Tokenizer::analyze_graph(std::ostream &dot_output,
 											std::string_view input,
 											TokenizeMode mode) const
 {
-	return analyze_impl(input, mode, &dot_output);
+	return analyze_impl(input, mode, &dot_output, nullptr);
 }
 
-std::vector<Token> Tokenizer::analyze_impl(std::string_view input,
-										   TokenizeMode mode,
-										   std::ostream *dot_output) const
+void Tokenizer::analyze_stream(std::string_view input, TokenizeMode mode,
+							   const TokenCallback &callback, bool *degraded) const
 {
-	// Get the dictionary pointer (works for both constructors)
-	dict::Dict *dict_ptr = get_dict();
-	if (!dict_ptr) {
-		return {};// Empty result if no dictionary
+	if (degraded) {
+		*degraded = false;
+	}
+	if (!get_dict()) {
+		return;
 	}
 
-	// Create a shared_ptr for lattice compatibility
-	std::shared_ptr<dict::Dict> shared_dict;
-	if (shared_dict_) {
-		// We already have a shared_ptr, use it directly
-		shared_dict = shared_dict_;
+	auto dict = shared_dict();
+	auto lattice = lattice::create_lattice(dict, user_dict_);
+	std::int32_t index = 0;
+	start_budget(*lattice);
+
+	auto emit = [&](const TokenView &token) {
+		callback(Token(token, dict, user_dict_));
+	};
+	analyze_normalized(input, emit, [&](std::string_view text, const TokenViewCallback &emit_view) {
+		analyze_chunks(*lattice, text, mode, index, emit_view);
+	});
+
+	if (degraded) {
+		*degraded = lattice->budget_exceeded();
+	}
+}
+
+void Tokenizer::analyze_document(lattice::Lattice &lattice, std::string_view input,
+								 TokenizeMode mode, std::int32_t &index,
+								 const TokenViewCallback &callback) const
+{
+	analyze_normalized(input, callback, [&](std::string_view text, const TokenViewCallback &emit) {
+		if (chunk_cache_) {
+			analyze_sentences(lattice, text, mode, index, emit);
+		}
+		else {
+			analyze_segment(lattice, text, 0, mode, index, true, true, emit);
+		}
+	});
+}
+
+void Tokenizer::analyze_normalized(std::string_view input, const TokenViewCallback &callback,
+								   const std::function<void(std::string_view, const TokenViewCallback &)> &analyze) const
+{
+	if (!config_.normalize) {
+		analyze(input, callback);
+		return;
+	}
+
+	// Already normalized text (the common case) is neither copied nor remapped
+	common::NormalizedText normalized;
+	common::normalize_nfkc(input, normalized);
+	if (!normalized.changed()) {
+		analyze(input, callback);
+		return;
+	}
+
+	analyze(normalized.text(), [&](const TokenView &token) {
+		callback(restore_original(token, normalized, input));
+	});
+}
+
+void Tokenizer::analyze_chunks(lattice::Lattice &lattice, std::string_view input,
+							   TokenizeMode mode, std::int32_t &index,
+							   const TokenViewCallback &callback) const
+{
+	SentenceChunker chunker(input, config_.max_chunk_bytes);
+	bool first = true;
+
+	// An empty input still produces BOS/EOS, like analyze() does
+	auto chunk = input.empty() ? std::optional<Chunk>(Chunk{}) : chunker.next();
+
+	while (chunk) {
+		auto next = chunker.next();
+
+		analyze_chunk(lattice, *chunk, mode, index, first, !next.has_value(), callback);
+
+		first = false;
+		chunk = next;
+	}
+}
+
+void Tokenizer::analyze_sentences(lattice::Lattice &lattice, std::string_view input,
+								  TokenizeMode mode, std::int32_t &index,
+								  const TokenViewCallback &callback) const
+{
+	if (input.empty()) {
+		analyze_segment(lattice, input, 0, mode, index, true, true, callback);
+		return;
+	}
+
+	// Chunks cut at the size limit are joined with the following ones up
+	// to the next terminator; the last chunk always ends the input
+	SentenceChunker chunker(input, config_.max_chunk_bytes);
+	std::size_t begin = 0;
+	while (auto chunk = chunker.next()) {
+		if (chunk->forced) {
+			continue;
+		}
+
+		const std::size_t end = chunk->offset + chunk->text.size();
+		analyze_chunk(lattice, Chunk{begin, input.substr(begin, end - begin)}, mode, index,
+					  begin == 0, end == input.size(), callback);
+		begin = end;
+	}
+}
+
+void Tokenizer::analyze_chunk(lattice::Lattice &lattice, const Chunk &chunk,
+							  TokenizeMode mode, std::int32_t &index,
+							  bool keep_bos, bool keep_eos,
+							  const TokenViewCallback &callback) const
+{
+	const std::string_view text = chunk.text;
+	const auto offset = static_cast<std::int32_t>(chunk.offset);
+	if (!chunk_cache_ || text.empty() || chunk.forced) {
+		analyze_segment(lattice, text, offset, mode, index, keep_bos, keep_eos, callback);
+		return;
+	}
+
+	// Chunks are cached without BOS/EOS and relative to their own start
+	const dict::Dict *dict = get_dict();
+	const auto tag = static_cast<std::uint32_t>(mode);
+	std::vector<TokenView> tokens;
+
+	if (!chunk_cache_->find(text, dict, user_dict_.get(), tokens, tag)) {
+		std::int32_t chunk_index = 0;
+		analyze_segment(lattice, text, 0, mode, chunk_index, false, false,
+						[&tokens](const TokenView &token) { tokens.push_back(token); });
+		// A degraded split is no answer for later calls with budget left
+		if (!lattice.budget_exceeded()) {
+			chunk_cache_->insert(text, tokens, tag);
+		}
+	}
+
+	if (keep_bos) {
+		emit_boundary(offset, index, callback);
+	}
+	for (const auto &token: tokens) {
+		callback(TokenView(index++, token.id(), token.token_class(), offset + token.start(),
+						   offset + token.end(), token.surface(), dict, user_dict_.get()));
+	}
+	if (keep_eos) {
+		emit_boundary(offset + static_cast<std::int32_t>(text.size()), index, callback);
+	}
+}
+
+void Tokenizer::emit_boundary(std::int32_t position, std::int32_t &index,
+							  const TokenViewCallback &callback) const
+{
+	if (config_.omit_bos_eos) {
+		++index;
+		return;
+	}
+
+	callback(TokenView(index++, lattice::BOS_EOS_ID, TokenClass::Dummy, position, position, {},
+					   get_dict(), user_dict_.get()));
+}
+
+std::vector<Token> Tokenizer::analyze_parallel(std::string_view input, TokenizeMode mode,
+											   common::ThreadPool &pool, bool *degraded) const
+{
+	if (degraded) {
+		*degraded = false;
+	}
+	if (!get_dict()) {
+		return {};
+	}
+
+	// The whole input is normalized up front; workers map tokens back
+	common::NormalizedText normalized;
+	std::string_view text = input;
+	if (config_.normalize) {
+		common::normalize_nfkc(input, normalized);
+		text = normalized.text();
+	}
+
+	std::vector<Chunk> chunks;
+	SentenceChunker chunker(text, config_.max_chunk_bytes);
+	while (auto chunk = chunker.next()) {
+		chunks.push_back(*chunk);
+	}
+	if (chunks.empty()) {
+		chunks.push_back(Chunk{});
+	}
+
+	// Group consecutive chunks so that each task carries enough work to
+	// amortize scheduling; a task is the half-open chunk range [first, last)
+	std::vector<std::pair<std::size_t, std::size_t>> tasks;
+	std::size_t first = 0;
+	std::size_t task_bytes = 0;
+	for (std::size_t i = 0; i < chunks.size(); ++i) {
+		task_bytes += chunks[i].text.size();
+		if (task_bytes >= config_.parallel_task_bytes || i + 1 == chunks.size()) {
+			tasks.emplace_back(first, i + 1);
+			first = i + 1;
+			task_bytes = 0;
+		}
+	}
+
+	struct TaskResult {
+		std::vector<Token> tokens;
+		/// Number of token indices used, including omitted BOS/EOS
+		std::int32_t consumed = 0;
+		bool degraded = false;
+	};
+	std::vector<TaskResult> results(tasks.size());
+	auto dict = shared_dict();
+
+	auto run_task = [&](std::size_t task) {
+		auto lattice = lattice::create_lattice(dict, user_dict_);
+		auto &result = results[task];
+		std::int32_t index = 0;
+		start_budget(*lattice);
+
+		for (std::size_t i = tasks[task].first; i < tasks[task].second; ++i) {
+			analyze_chunk(*lattice, chunks[i], mode, index, i == 0, i + 1 == chunks.size(),
+						  [&](const TokenView &token) {
+							  if (normalized.changed()) {
+								  result.tokens.emplace_back(restore_original(token, normalized, input), dict,
+															 user_dict_);
+							  }
+							  else {
+								  result.tokens.emplace_back(token, dict, user_dict_);
+							  }
+						  });
+		}
+
+		result.consumed = index;
+		result.degraded = lattice->budget_exceeded();
+	};
+
+	if (tasks.size() == 1) {
+		run_task(0);
 	}
 	else {
-		// Create a shared_ptr from unique_ptr with no-op deleter
-		shared_dict = std::shared_ptr<dict::Dict>(dict_.get(), [](dict::Dict *) {
-			// No-op deleter since unique_ptr owns the dict
-		});
+		pool.parallel_for(tasks.size(), run_task);
 	}
 
-	auto lattice = lattice::create_lattice(shared_dict, nullptr);
+	// Stitch task results in input order, renumbering token indices
+	std::size_t total = 0;
+	for (const auto &result: results) {
+		total += result.tokens.size();
+	}
 
-	// Build lattice from input
-	lattice->build(input);
+	std::vector<Token> tokens;
+	tokens.reserve(total);
 
-	// Forward pass (Viterbi algorithm)
-	lattice::LatticeMode lattice_mode = lattice::LatticeMode::Normal;// Default to Normal
+	std::int32_t base = 0;
+	for (auto &result: results) {
+		for (auto &token: result.tokens) {
+			token.set_index(base + token.index());
+			tokens.push_back(std::move(token));
+		}
+		base += result.consumed;
+		if (degraded && result.degraded) {
+			*degraded = true;
+		}
+	}
+
+	return tokens;
+}
+
+void Tokenizer::analyze_batch(std::span<const std::string_view> documents, TokenizeMode mode,
+							  common::ThreadPool &pool, const BatchCallback &callback,
+							  bool *degraded) const
+{
+	if (degraded) {
+		std::fill_n(degraded, documents.size(), false);
+	}
+	if (!get_dict() || documents.empty()) {
+		return;
+	}
+
+	// A few blocks per worker keeps the load balanced when document sizes vary
+	const std::size_t blocks = std::min(documents.size(), pool.size() * 4);
+	const std::size_t block_size = (documents.size() + blocks - 1) / blocks;
+	auto dict = shared_dict();
+
+	pool.parallel_for(blocks, [&](std::size_t block) {
+		const std::size_t first = block * block_size;
+		const std::size_t last = std::min(documents.size(), first + block_size);
+		auto lattice = lattice::create_lattice(dict, user_dict_);
+
+		for (std::size_t doc = first; doc < last; ++doc) {
+			std::vector<Token> tokens;
+			std::int32_t index = 0;
+			start_budget(*lattice);
+			analyze_document(*lattice, documents[doc], mode, index,
+							 [&](const TokenView &token) {
+								 tokens.emplace_back(token, dict, user_dict_);
+							 });
+
+			if (degraded) {
+				degraded[doc] = lattice->budget_exceeded();
+			}
+			callback(doc, std::move(tokens));
+		}
+	});
+}
+
+std::vector<std::vector<Token>>
+Tokenizer::analyze_batch(std::span<const std::string_view> documents, TokenizeMode mode,
+						 common::ThreadPool &pool, bool *degraded) const
+{
+	std::vector<std::vector<Token>> results(documents.size());
+
+	analyze_batch(
+		documents, mode, pool,
+		[&results](std::size_t document, std::vector<Token> &&tokens) {
+			results[document] = std::move(tokens);
+		},
+		degraded);
+
+	return results;
+}
+
+std::shared_ptr<dict::Dict> Tokenizer::shared_dict() const
+{
+	if (shared_dict_) {
+		// We already have a shared_ptr, use it directly
+		return shared_dict_;
+	}
+
+	// Create a shared_ptr from unique_ptr with no-op deleter
+	return std::shared_ptr<dict::Dict>(dict_.get(), [](dict::Dict *) {
+		// No-op deleter since unique_ptr owns the dict
+	});
+}
+
+void Tokenizer::run_lattice(lattice::Lattice &lattice, std::string_view input,
+							TokenizeMode mode) const
+{
+	lattice.set_beam_width(config_.beam_width);
+
+	// Resolve the mode once; the lattice passes are specialized per mode
 	switch (mode) {
 	case TokenizeMode::Normal:
-		lattice_mode = lattice::LatticeMode::Normal;
+		run_lattice_passes<lattice::LatticeMode::Normal>(lattice, input);
 		break;
 	case TokenizeMode::Search:
-		lattice_mode = lattice::LatticeMode::Search;
+		run_lattice_passes<lattice::LatticeMode::Search>(lattice, input);
 		break;
 	case TokenizeMode::Extended:
-		lattice_mode = lattice::LatticeMode::Extended;
+		run_lattice_passes<lattice::LatticeMode::Extended>(lattice, input);
 		break;
 	}
+}
 
-	lattice->forward(lattice_mode);
-	lattice->backward(lattice_mode);
+std::vector<Token> Tokenizer::analyze_impl(std::string_view input,
+										   TokenizeMode mode,
+										   std::ostream *dot_output,
+										   bool *degraded) const
+{
+	if (degraded) {
+		*degraded = false;
+	}
 
-	// Export DOT if requested
-	if (dot_output) {
-		lattice->export_dot(*dot_output);
+	// Get the dictionary pointer (works for both constructors)
+	dict::Dict *dict_ptr = get_dict();
+	if (!dict_ptr) {
+		return {};// Empty result if no dictionary
 	}
 
-	// Convert lattice output to tokens
+	auto dict = shared_dict();
+	auto lattice = lattice::create_lattice(dict, user_dict_);
 	std::vector<Token> tokens;
+	std::int32_t index = 0;
+	start_budget(*lattice);
+	auto collect = [&](const TokenView &token) {
+		tokens.emplace_back(token, dict, user_dict_);
+	};
+
+	if (!dot_output) {
+		analyze_document(*lattice, input, mode, index, collect);
+		if (degraded) {
+			*degraded = lattice->budget_exceeded();
+		}
+		return tokens;
+	}
+
+	// The graph always covers the whole input, so the prepass does not apply
+	run_lattice(*lattice, input, mode);
+	lattice->export_dot(*dot_output);
+
+	// Convert lattice output to tokens
 	tokens.reserve(lattice->output().size());
+	emit_tokens(*lattice, 0, index, true, true, collect);
 
-	for (std::size_t i = 0; i < lattice->output().size(); ++i) {
-		const auto *node = lattice->output()[i];
-		if (config_.omit_bos_eos && node->is_bos_eos()) {
-			continue;
+	return tokens;
+}
+
+TokenizeResult Tokenizer::analyze_view(std::string_view input, TokenizeMode mode) const
+{
+	return analyze_view(input, mode, {});
+}
+
+TokenizeResult Tokenizer::analyze_view(std::string_view input, TokenizeMode mode,
+									   std::span<const common::ByteRun> runs) const
+{
+	if (!get_dict()) {
+		return {};
+	}
+
+	auto lattice = create_lattice();
+	return analyze_view(*lattice, input, mode, runs);
+}
+
+TokenizeResult Tokenizer::analyze_view(lattice::Lattice &lattice, std::string_view input,
+									   TokenizeMode mode, std::span<const common::ByteRun> runs) const
+{
+	if (!get_dict()) {
+		return {};
+	}
+
+	// Rewritten normalized surfaces view text that only lives during the
+	// analysis; they are gathered into one buffer the result keeps
+	std::vector<TokenView> tokens;
+	std::string normalized;
+	std::vector<std::pair<std::size_t, std::size_t>> rewritten;
+	visit_impl(lattice, input, mode, runs, [&](const TokenView &token) {
+		if (token.rewritten()) {
+			rewritten.emplace_back(tokens.size(), normalized.size());
+			normalized.append(token.normalized_surface());
+		}
+		tokens.push_back(token);
+	});
+
+	std::shared_ptr<const std::string> storage;
+	if (!rewritten.empty()) {
+		auto owned = std::make_shared<const std::string>(std::move(normalized));
+		for (const auto &[i, offset]: rewritten) {
+			tokens[i].set_normalized_surface(
+				std::string_view(*owned).substr(offset, tokens[i].normalized_surface().size()));
 		}
+		storage = std::move(owned);
+	}
 
-		// Calculate end position (start + surface byte length)
-		std::int32_t end_pos = node->position() + static_cast<std::int32_t>(node->surface().length());
+	TokenizeResult result(shared_dict(), user_dict_, std::move(tokens), std::move(storage));
+	result.set_degraded(lattice.budget_exceeded());
+	return result;
+}
 
-		// Use the full constructor that takes TokenClass explicitly
-		tokens.emplace_back(
-			static_cast<std::int32_t>(i),               // index
-			node->id(),                                 // id
-			static_cast<TokenClass>(node->node_class()),// token_class
-			node->position(),                           // position
-			node->position(),                           // start
-			end_pos,                                    // end
-			node->surface(),                            // surface
-			shared_dict,                                // dict
-			nullptr                                     // user_dict
-		);
+void Tokenizer::visit_impl(lattice::Lattice &lattice, std::string_view input, TokenizeMode mode,
+						   std::span<const common::ByteRun> runs, const TokenViewCallback &callback) const
+{
+	if (!get_dict()) {
+		return;
 	}
 
-	return tokens;
+	std::int32_t index = 0;
+	start_budget(lattice);
+
+	// Runs describe the original bytes, so they are of no use when the
+	// text is normalized first
+	if (!use_script_prepass() || runs.empty() || chunk_cache_ || config_.normalize) {
+		// An empty input has no runs but still gets BOS/EOS
+		analyze_document(lattice, input, mode, index, callback);
+	}
+	else {
+		for (std::size_t i = 0; i < runs.size(); ++i) {
+			const auto &run = runs[i];
+			analyze_run(lattice, input.substr(run.offset, run.length), run.ascii,
+						static_cast<std::int32_t>(run.offset), mode, index,
+						i == 0, i + 1 == runs.size(), callback);
+		}
+	}
+}
+
+void Tokenizer::start_budget(lattice::Lattice &lattice) const
+{
+	auto deadline = std::chrono::steady_clock::time_point::max();
+	if (config_.time_budget.count() > 0) {
+		deadline = std::chrono::steady_clock::now() + config_.time_budget;
+	}
+	lattice.set_budget(config_.max_edges, deadline);
+}
+
+std::unique_ptr<lattice::Lattice> Tokenizer::create_lattice() const
+{
+	return lattice::create_lattice(shared_dict(), user_dict_);
 }
 
 namespace factory {
@@ -2,9 +2,21 @@
 #include <cassert>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <thread>
+#include <filesystem>
+#include <fstream>
 
 #include "kagome/tokenizer/tokenizer.hpp"
+#include "kagome/tokenizer/lattice/category_scanner.hpp"
+#include "kagome/tokenizer/lattice/lattice.hpp"
+#include "kagome/tokenizer/result_cache.hpp"
 #include "kagome/dict/dict.hpp"
+#include "kagome/common/script.hpp"
+#include "kagome/common/hash.hpp"
+#include "kagome/common/normalize.hpp"
+#include <unicode/utf8.h>
+#include <unicode/uscript.h>
 
 void test_basic_tokenization() {
     std::cout << "Testing basic tokenization...\n";
@@ -52,6 +64,26 @@ void test_wakati_mode() {
     auto tokens = tokenizer.wakati(test_text);
     
     assert(!tokens.empty());
+    
+    // The view variant yields the surfaces of analyze(), pointing into the
+    // input at each token's offset
+    std::vector<std::string_view> surfaces{"stale"};
+    auto lattice = tokenizer.create_lattice();
+    for (std::string text: {std::string("すもももももももものうち"), test_text}) {
+        tokenizer.wakati(*lattice, text, surfaces);
+        std::vector<kagome::tokenizer::Token> expected;
+        for (auto &token: tokenizer.analyze(text, kagome::tokenizer::TokenizeMode::Normal)) {
+            if (!token.surface().empty()) {
+                expected.push_back(std::move(token));
+            }
+        }
+        assert(surfaces.size() == expected.size());
+        for (std::size_t i = 0; i < surfaces.size(); ++i) {
+            assert(surfaces[i] == expected[i].surface());
+            assert(surfaces[i].data() == text.data() + expected[i].start());
+            assert(surfaces[i].data() + surfaces[i].size() <= text.data() + text.size());
+        }
+    }
     std::cout << "✓ Wakati mode test passed\n";
 }
 
@@ -116,6 +148,915 @@ void test_token_features() {
     std::cout << "✓ Token features test passed\n";
 }
 
+void test_streaming_tokenization() {
+    std::cout << "Testing streaming tokenization...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::TokenizerConfig config;
+    config.omit_bos_eos = true;
+    config.max_chunk_bytes = 16;
+    kagome::tokenizer::Tokenizer tokenizer(dict, config);
+    
+    std::string test_text = "すもも。もも！\nすもももももも abc def ghi jkl";
+    std::vector<kagome::tokenizer::Token> tokens;
+    tokenizer.analyze_stream(test_text, kagome::tokenizer::TokenizeMode::Normal,
+                             [&tokens](kagome::tokenizer::Token &&token) {
+                                 tokens.push_back(std::move(token));
+                             });
+    
+    assert(!tokens.empty());
+    
+    // Offsets must be global and tokens must cover the input in order
+    std::int32_t expected_start = 0;
+    for (const auto& token : tokens) {
+        assert(token.start() == expected_start);
+        assert(test_text.compare(token.start(), token.end() - token.start(), token.surface()) == 0);
+        expected_start = token.end();
+    }
+    assert(expected_start == static_cast<std::int32_t>(test_text.size()));
+    
+    // Chunks never split UTF-8 sequences and respect sentence terminators
+    kagome::tokenizer::SentenceChunker chunker(test_text, 16);
+    std::size_t chunks = 0;
+    while (auto chunk = chunker.next()) {
+        assert(chunk->text.size() <= 16 || chunk->text.find('\n') != std::string_view::npos);
+        assert((static_cast<unsigned char>(chunk->text[0]) & 0xC0) != 0x80);
+        ++chunks;
+    }
+    assert(chunks > 1);
+    
+    // A long run of terminators is split at the size limit too
+    std::string terminators;
+    for (int i = 0; i < 100; ++i) {
+        terminators += i < 50 ? "。" : "！";
+    }
+    kagome::tokenizer::SentenceChunker run_chunker(terminators, 16);
+    std::size_t run_bytes = 0;
+    while (auto chunk = run_chunker.next()) {
+        assert(chunk->text.size() <= 16);
+        assert(!chunk->forced);
+        run_bytes += chunk->text.size();
+    }
+    assert(run_bytes == terminators.size());
+    
+    // Cuts at the size limit are marked, the end of the input is not
+    std::string unterminated(40, 'a');
+    kagome::tokenizer::SentenceChunker limit_chunker(unterminated, 16);
+    auto cut = limit_chunker.next();
+    assert(cut && cut->forced && cut->text.size() == 16);
+    cut = limit_chunker.next();
+    assert(cut && cut->forced);
+    cut = limit_chunker.next();
+    assert(cut && !cut->forced && cut->offset + cut->text.size() == unterminated.size());
+    assert(!limit_chunker.next());
+    
+    std::cout << "✓ Streaming tokenization test passed\n";
+}
+
+void test_parallel_tokenization() {
+    std::cout << "Testing parallel tokenization...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::TokenizerConfig config;
+    config.max_chunk_bytes = 32;
+    config.parallel_task_bytes = 16;
+    kagome::tokenizer::Tokenizer tokenizer(dict, config);
+    
+    std::string test_text;
+    for (int i = 0; i < 50; ++i) {
+        test_text += "すもももももももものうち。test 123！\n";
+    }
+    
+    std::vector<kagome::tokenizer::Token> sequential;
+    tokenizer.analyze_stream(test_text, kagome::tokenizer::TokenizeMode::Normal,
+                             [&sequential](kagome::tokenizer::Token &&token) {
+                                 sequential.push_back(std::move(token));
+                             });
+    
+    kagome::common::ThreadPool pool(4);
+    auto parallel = tokenizer.analyze_parallel(test_text, kagome::tokenizer::TokenizeMode::Normal, pool);
+    
+    assert(parallel.size() == sequential.size());
+    for (std::size_t i = 0; i < parallel.size(); ++i) {
+        assert(parallel[i] == sequential[i]);
+        assert(parallel[i].index() == sequential[i].index());
+        assert(parallel[i].start() == sequential[i].start());
+        assert(parallel[i].end() == sequential[i].end());
+    }
+    
+    std::cout << "✓ Parallel tokenization test passed\n";
+}
+
+void test_batch_tokenization() {
+    std::cout << "Testing batch tokenization...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::TokenizerConfig config;
+    config.omit_bos_eos = true;
+    kagome::tokenizer::Tokenizer tokenizer(dict, config);
+    
+    std::vector<std::string> texts = {"すもも", "", "もものうち", "東京都に住んでいます", "abc 123"};
+    std::vector<std::string_view> documents(texts.begin(), texts.end());
+    
+    kagome::common::ThreadPool pool(3);
+    auto results = tokenizer.analyze_batch(documents, kagome::tokenizer::TokenizeMode::Normal, pool);
+    
+    assert(results.size() == documents.size());
+    for (std::size_t i = 0; i < documents.size(); ++i) {
+        auto expected = tokenizer.analyze(documents[i], kagome::tokenizer::TokenizeMode::Normal);
+        assert(results[i].size() == expected.size());
+        for (std::size_t j = 0; j < expected.size(); ++j) {
+            assert(results[i][j] == expected[j]);
+            assert(results[i][j].id() == expected[j].id());
+            assert(results[i][j].index() == expected[j].index());
+            assert(results[i][j].start() == expected[j].start());
+            assert(results[i][j].end() == expected[j].end());
+            assert(results[i][j].surface() == expected[j].surface());
+            assert(results[i][j].pos() == expected[j].pos());
+        }
+    }
+    
+    // The pool is reused after its workers went idle
+    auto again = tokenizer.analyze_batch(documents, kagome::tokenizer::TokenizeMode::Normal, pool);
+    for (std::size_t i = 0; i < documents.size(); ++i) {
+        assert(again[i].size() == results[i].size());
+        for (std::size_t j = 0; j < again[i].size(); ++j) {
+            assert(again[i][j].id() == results[i][j].id());
+            assert(again[i][j].start() == results[i][j].start());
+        }
+    }
+    
+    std::cout << "✓ Batch tokenization test passed\n";
+}
+
+void test_script_prepass() {
+    std::cout << "Testing script prepass...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::TokenizerConfig config;
+    config.script_prepass = true;
+    kagome::tokenizer::Tokenizer tokenizer(dict, config);
+    kagome::tokenizer::Tokenizer reference(dict);
+    
+    std::string test_text = "See https://example.com すもももももも abc123 もものうち";
+    
+    // ASCII runs bypass the lattice but yield the same words and entries
+    for (auto mode: {kagome::tokenizer::TokenizeMode::Normal, kagome::tokenizer::TokenizeMode::Search,
+                     kagome::tokenizer::TokenizeMode::Extended}) {
+        auto plain = tokenizer.analyze(test_text, mode);
+        auto lattice = reference.analyze(test_text, mode);
+        assert(plain.size() == lattice.size());
+        for (std::size_t i = 0; i < plain.size(); ++i) {
+            assert(plain[i].surface() == lattice[i].surface());
+            assert(plain[i].start() == lattice[i].start());
+            assert(plain[i].index() == lattice[i].index());
+            assert(plain[i].id() == lattice[i].id());
+            assert(plain[i].token_class() == lattice[i].token_class());
+            assert(plain[i].pos() == lattice[i].pos());
+            assert(plain[i].features() == lattice[i].features());
+        }
+    }
+    auto tokens = tokenizer.analyze(test_text, kagome::tokenizer::TokenizeMode::Normal);
+    
+    // Runs gathered during detection stand in for the prepass scan
+    std::vector<kagome::common::ByteRun> runs;
+    auto counts = kagome::common::count_japanese_chars(test_text, runs);
+    assert(counts.japanese_chars > 0 && !runs.empty());
+    std::size_t covered = 0;
+    for (const auto &run: runs) {
+        assert(run.offset == covered && run.length > 0);
+        covered += run.length;
+    }
+    assert(covered == test_text.size());
+    
+    auto views = tokenizer.analyze_view(test_text, kagome::tokenizer::TokenizeMode::Normal, runs);
+    assert(views.size() == tokens.size());
+    for (std::size_t i = 0; i < views.size(); ++i) {
+        assert(views.to_token(i) == tokens[i]);
+    }
+    
+    std::cout << "✓ Script prepass test passed\n";
+}
+
+void test_category_scanner() {
+    std::cout << "Testing category run scanner...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::lattice::CategoryScanner scanner(*dict);
+    
+    // The ranges are built once when the dictionary is loaded
+    assert(dict->ascii_category_ranges[static_cast<std::uint8_t>(dict->character_category(U'a'))].count > 0);
+    
+    // Runs longer than one vector, ending in the middle of one, and
+    // crossing into multi-byte characters of the same category
+    std::string test_text = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZｘｙｚ 0123456789012345678901234567890123456789, "
+                            "カタカナカタカナカタカナカタカナカタカナ漢字";
+    
+    std::int32_t pos = 0;
+    while (pos < static_cast<std::int32_t>(test_text.size())) {
+        UChar32 ch;
+        U8_NEXT(reinterpret_cast<const uint8_t *>(test_text.data()), pos,
+                static_cast<std::int32_t>(test_text.size()), ch);
+        auto category = dict->character_category(ch);
+        
+        // Scalar reference
+        std::int32_t expected_pos = pos;
+        std::int32_t expected = 0;
+        while (expected_pos < static_cast<std::int32_t>(test_text.size()) && expected < 40) {
+            std::int32_t next = expected_pos;
+            UChar32 next_ch;
+            U8_NEXT(reinterpret_cast<const uint8_t *>(test_text.data()), next,
+                    static_cast<std::int32_t>(test_text.size()), next_ch);
+            if (next_ch < 0 || dict->character_category(next_ch) != category) {
+                break;
+            }
+            expected_pos = next;
+            ++expected;
+        }
+        
+        std::int32_t scan_pos = pos;
+        assert(scanner.scan(test_text, scan_pos, category, 40) == expected);
+        assert(scan_pos == expected_pos);
+    }
+    
+    std::cout << "✓ Category run scanner test passed\n";
+}
+
+void test_token_views() {
+    std::cout << "Testing token views...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::Tokenizer tokenizer(dict);
+    
+    std::string test_text = "すもももももももものうち abc";
+    auto tokens = tokenizer.analyze(test_text, kagome::tokenizer::TokenizeMode::Normal);
+    auto views = tokenizer.analyze_view(test_text, kagome::tokenizer::TokenizeMode::Normal);
+    
+    assert(views.size() == tokens.size());
+    for (std::size_t i = 0; i < views.size(); ++i) {
+        const auto &view = views[i];
+        assert(view.surface() == tokens[i].surface());
+        assert(view.start() == tokens[i].start() && view.end() == tokens[i].end());
+        assert(view.base_form() == tokens[i].base_form());
+        assert(view.pos() == tokens[i].pos());
+        
+        // In-place accessors agree with the copying ones
+        assert(view.base_form_view() == tokens[i].base_form());
+        assert(view.reading_view() == tokens[i].reading());
+        assert(view.pos_view().size() == tokens[i].pos().size());
+        
+        // Surfaces are slices of the input rather than copies
+        assert(view.surface().empty() || view.surface().data() == test_text.data() + view.start());
+        assert(views.to_token(i) == tokens[i]);
+    }
+    
+    std::cout << "✓ Token views test passed\n";
+}
+
+void test_entry_flags() {
+    std::cout << "Testing entry classification flags...\n";
+    
+    auto dict = kagome::dict::DictLoader::create_fallback_dict();
+    
+    // Fallback entries are 動詞, 形容詞 and one without POS names
+    std::vector<kagome::dict::PosFlagRule> rules = {
+        {{"動詞"}, kagome::dict::ENTRY_FLAG_STOP_WORD},
+        {{"形容詞"}, kagome::dict::ENTRY_FLAG_PUNCTUATION},
+        {{"形容詞", "自立"}, kagome::dict::ENTRY_FLAG_STOP_WORD}};
+    dict->classify_entries(rules);
+    
+    assert(dict->entry_flags.size() == dict->morphs.size());
+    assert(dict->known_flags(0) == kagome::dict::ENTRY_FLAG_STOP_WORD);
+    assert(dict->known_flags(1) == kagome::dict::ENTRY_FLAG_PUNCTUATION);
+    assert(dict->known_flags(2) == 0);
+    assert(dict->known_flags(100) == 0);
+    
+    kagome::tokenizer::TokenView view(0, 0, kagome::tokenizer::TokenClass::Known, 0, 0, "", dict.get());
+    assert(view.flags() == kagome::dict::ENTRY_FLAG_STOP_WORD);
+    
+    std::cout << "✓ Entry classification flags test passed\n";
+}
+
+void test_base_form_pool() {
+    std::cout << "Testing interned base forms...\n";
+    
+    auto dict = kagome::dict::DictLoader::create_fallback_dict();
+    
+    assert(dict->base_form_ids.size() == dict->morphs.size());
+    assert(dict->unk_dict.base_form_ids.size() == dict->unk_dict.morphs.size());
+    
+    // Pooled base forms match the ones resolved from the features
+    for (std::size_t id = 0; id < dict->morphs.size(); ++id) {
+        auto pooled = dict->known_base_form(static_cast<std::int32_t>(id));
+        assert(pooled);
+        assert(*pooled == dict->entry_base_form(false, static_cast<std::int32_t>(id)));
+        assert(pooled->data()[pooled->size()] == '\0');
+    }
+    assert(!dict->known_base_form(static_cast<std::int32_t>(dict->morphs.size())));
+    
+    // Strings come back as added, each followed by a NUL byte
+    kagome::dict::StringPool pool;
+    assert(pool.size() == 0);
+    auto first = pool.add("食べる");
+    auto second = pool.add("");
+    assert(pool.get(first) == "食べる");
+    assert(pool.get(second).empty());
+    assert(pool.size() == 2);
+    
+    // Interning keeps one pool entry per distinct base form
+    assert(dict->base_form_pool.size() <= dict->morphs.size() + dict->unk_dict.morphs.size());
+    
+    std::cout << "✓ Interned base forms test passed\n";
+}
+
+void test_lattice_input_views() {
+    std::cout << "Testing lattice input views...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    auto lattice = kagome::tokenizer::lattice::create_lattice(dict);
+    
+    // Repeated words must map to their own occurrence, not the first one
+    std::string test_text = "もも abc もも abc";
+    for (auto mode: {kagome::tokenizer::lattice::LatticeMode::Normal,
+                     kagome::tokenizer::lattice::LatticeMode::Extended}) {
+        lattice->build(test_text, mode);
+        lattice->forward(mode);
+        lattice->backward(mode);
+        
+        assert(lattice->input().data() == test_text.data());
+        for (const auto *node: lattice->output()) {
+            auto surface = node->surface();
+            assert(surface.empty() || surface.data() == test_text.data() + node->position());
+        }
+    }
+    
+    kagome::tokenizer::Tokenizer tokenizer(dict);
+    auto views = tokenizer.analyze_view(test_text, kagome::tokenizer::TokenizeMode::Normal);
+    std::int32_t last_end = 0;
+    for (const auto &view: views) {
+        if (view.surface().empty()) {
+            continue;
+        }
+        // Offsets advance through the input, so the second "もも" is not
+        // mapped onto the first
+        assert(view.start() >= last_end);
+        assert(view.surface().data() == test_text.data() + view.start());
+        last_end = view.end();
+    }
+    assert(last_end == static_cast<std::int32_t>(test_text.size()));
+    
+    std::cout << "✓ Lattice input views test passed\n";
+}
+
+void test_script_detection() {
+    std::cout << "Testing Japanese script detection...\n";
+    
+    // Mixed scripts, a supplementary Han character and an invalid byte
+    std::string test_text = "Hello すもも カタカナ 漢字 \xF0\xA0\x80\x8B Ωμέγα \xFF end";
+    
+    std::size_t total = 0;
+    std::size_t japanese = 0;
+    std::int32_t pos = 0;
+    const auto len = static_cast<std::int32_t>(test_text.size());
+    while (pos < len) {
+        UChar32 ch;
+        U8_NEXT(reinterpret_cast<const std::uint8_t *>(test_text.data()), pos, len, ch);
+        ++total;
+        UErrorCode error = U_ZERO_ERROR;
+        UScriptCode script = uscript_getScript(ch, &error);
+        if (ch >= 0 && U_SUCCESS(error) &&
+            (script == USCRIPT_HIRAGANA || script == USCRIPT_KATAKANA || script == USCRIPT_HAN)) {
+            ++japanese;
+            assert(kagome::common::is_japanese_script(static_cast<char32_t>(ch)));
+        }
+    }
+    
+    auto counts = kagome::common::count_japanese_chars(test_text);
+    assert(counts.total_chars == total);
+    assert(counts.japanese_chars == japanese);
+    assert(!kagome::common::is_japanese_script(U'A'));
+    
+    // Confidence curve
+    assert(kagome::common::japanese_confidence(kagome::common::count_japanese_chars("plain ascii")) == -1.0);
+    assert(kagome::common::japanese_confidence({10, 10}) == 0.95);
+    assert(kagome::common::japanese_confidence({100, 1}) == 0.3 + 0.01 * 0.65);
+    
+    // Sampling a uniform text gives the same ratio
+    std::string repeated;
+    for (int i = 0; i < 4096; ++i) {
+        repeated += "ひらがなabcd";
+    }
+    auto exact = kagome::common::count_japanese_chars(repeated);
+    auto sampled = kagome::common::sample_japanese_chars(repeated, 4096);
+    assert(sampled.total_chars < exact.total_chars);
+    double exact_confidence = kagome::common::japanese_confidence(exact);
+    double sampled_confidence = kagome::common::japanese_confidence(sampled);
+    assert(sampled_confidence > exact_confidence - 0.01 && sampled_confidence < exact_confidence + 0.01);
+    assert(kagome::common::sample_japanese_chars(test_text, 0).total_chars == total);
+    
+    std::cout << "✓ Japanese script detection test passed\n";
+}
+
+void test_lattice_reuse() {
+    std::cout << "Testing lattice reuse across calls and threads...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::Tokenizer tokenizer(dict);
+    
+    std::vector<std::string> texts = {"すもももももももものうち", "abc 東京都 123", ""};
+    std::vector<kagome::tokenizer::TokenizeResult> expected;
+    for (const auto &text: texts) {
+        expected.push_back(tokenizer.analyze_view(text, kagome::tokenizer::TokenizeMode::Normal));
+    }
+    
+    // Every thread keeps one lattice for all of its calls
+    std::vector<std::thread> threads;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            auto lattice = tokenizer.create_lattice();
+            for (int round = 0; round < 10; ++round) {
+                for (std::size_t i = 0; i < texts.size(); ++i) {
+                    auto result = tokenizer.analyze_view(*lattice, texts[i], kagome::tokenizer::TokenizeMode::Normal);
+                    if (result.size() != expected[i].size()) {
+                        ++mismatches;
+                        continue;
+                    }
+                    for (std::size_t j = 0; j < result.size(); ++j) {
+                        if (result.to_token(j) != expected[i].to_token(j)) {
+                            ++mismatches;
+                        }
+                    }
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    assert(mismatches == 0);
+    
+    std::cout << "✓ Lattice reuse test passed\n";
+}
+
+void test_user_dict_and_beam() {
+    std::cout << "Testing user dictionary and beam search...\n";
+    
+    auto path = std::filesystem::temp_directory_path() / "kagome_test_userdict.txt";
+    {
+        std::ofstream out(path);
+        out << "# surface,segmentation,readings,pos\n";
+        out << "東京スカイツリー,東京 スカイツリー,トウキョウ スカイツリー,カスタム名詞\n";
+        out << "\n";
+        out << "kagome,kagome,カゴメ,カスタム名詞\n";
+    }
+    
+    auto user_dict = kagome::dict::factory::load_user_dict(path.string());
+    assert(user_dict->contents.size() == 2);
+    
+    kagome::tokenizer::TokenizerConfig config;
+    config.omit_bos_eos = true;
+    config.script_prepass = true;
+    kagome::tokenizer::Tokenizer tokenizer(kagome::dict::factory::create_ipa_dict(), config);
+    tokenizer.set_user_dict(user_dict);
+    
+    // The ASCII entry must be found even though the prepass is enabled
+    for (std::string_view surface: {"東京スカイツリー", "kagome"}) {
+        std::string text = "今日は" + std::string(surface) + "へ";
+        auto tokens = tokenizer.tokenize(text);
+        bool found = false;
+        for (const auto &token: tokens) {
+            if (token.surface() == surface) {
+                assert(token.token_class() == kagome::tokenizer::TokenClass::User);
+                assert(token.pos().at(0) == "カスタム名詞");
+                found = true;
+            }
+        }
+        assert(found);
+    }
+    
+    {
+        std::ofstream out(path);
+        out << "壊れた行\n";
+    }
+    bool thrown = false;
+    try {
+        (void)kagome::dict::factory::load_user_dict(path.string());
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+    std::filesystem::remove(path);
+    
+    // A beam wide enough for every position matches the exact search; a
+    // narrow one still covers the whole input
+    std::string text = "すもももももももものうち東京都に住んでいます";
+    kagome::tokenizer::Tokenizer exact(kagome::dict::factory::create_ipa_dict(), config);
+    auto expected = exact.tokenize(text);
+    for (std::size_t beam: {std::size_t{1}, std::size_t{4}, std::size_t{1000}}) {
+        config.beam_width = beam;
+        kagome::tokenizer::Tokenizer beamed(kagome::dict::factory::create_ipa_dict(), config);
+        auto tokens = beamed.tokenize(text);
+        std::string joined;
+        for (const auto &token: tokens) {
+            joined += token.surface();
+        }
+        assert(joined == text);
+        if (beam == 1000) {
+            assert(tokens.size() == expected.size());
+            for (std::size_t i = 0; i < tokens.size(); ++i) {
+                assert(tokens[i].surface() == expected[i].surface());
+            }
+        }
+    }
+    
+    std::cout << "✓ User dictionary and beam search test passed\n";
+}
+
+void test_result_cache() {
+    std::cout << "Testing result cache...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::Tokenizer tokenizer(dict);
+    kagome::tokenizer::ResultCache cache(16 * 1024);
+    
+    std::string text = "すもももももももものうち";
+    auto expected = tokenizer.analyze_view(text, kagome::tokenizer::TokenizeMode::Normal);
+    
+    std::vector<kagome::tokenizer::TokenView> tokens;
+    assert(!cache.find(text, dict.get(), nullptr, tokens));
+    cache.insert(text, expected.tokens());
+    
+    // A hit rebuilds the views over the caller's copy of the text
+    std::string copy = text;
+    assert(cache.find(copy, dict.get(), nullptr, tokens));
+    assert(tokens.size() == expected.size());
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        assert(tokens[i].id() == expected[i].id());
+        assert(tokens[i].start() == expected[i].start());
+        assert(tokens[i].surface() == expected[i].surface());
+        assert(tokens[i].surface().empty() || tokens[i].surface().data() == copy.data() + tokens[i].start());
+    }
+    assert(!cache.find("すもも", dict.get(), nullptr, tokens));
+    
+    auto stats = cache.stats();
+    assert(stats.hits == 1 && stats.misses == 2 && stats.insertions == 1 && stats.entries == 1);
+    
+    // Entries keep the degraded flag they were stored with
+    bool degraded = true;
+    assert(cache.find(text, dict.get(), nullptr, tokens, 0, &degraded));
+    assert(!degraded);
+    cache.insert(text, expected.tokens(), 1, true);
+    assert(cache.find(text, dict.get(), nullptr, tokens, 1, &degraded));
+    assert(degraded);
+    
+    // The cap holds; the recently hit entry survives the first clock sweep
+    for (int i = 0; i < 200; ++i) {
+        std::string other = "東京都" + std::to_string(i);
+        auto result = tokenizer.analyze_view(other, kagome::tokenizer::TokenizeMode::Normal);
+        cache.insert(other, result.tokens());
+        assert(cache.stats().bytes <= cache.max_bytes());
+        if (i == 0) {
+            assert(cache.find(text, dict.get(), nullptr, tokens));
+        }
+    }
+    stats = cache.stats();
+    assert(stats.evictions > 0);
+    assert(stats.entries + stats.evictions == stats.insertions);
+    
+    cache.clear();
+    assert(cache.stats().entries == 0 && cache.stats().bytes == 0);
+    assert(!cache.find(text, dict.get(), nullptr, tokens));
+    
+    std::cout << "✓ Result cache test passed\n";
+}
+
+void test_chunk_cache() {
+    std::cout << "Testing chunk cache...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::TokenizerConfig config;
+    config.script_prepass = true;
+    kagome::tokenizer::Tokenizer plain(dict, config);
+    kagome::tokenizer::Tokenizer cached(dict, config);
+    auto cache = std::make_shared<kagome::tokenizer::ResultCache>(1024 * 1024);
+    cached.set_chunk_cache(cache);
+    
+    // Unique bodies sharing a footer sentence
+    const std::string footer = "配信停止はこちらから。";
+    std::vector<std::string> bodies = {
+        "今日は晴れです。" + footer,
+        "明日は雨が降るでしょう。" + footer + "\n",
+        footer,
+        footer + "東京都に住んでいます。"};
+    
+    for (auto mode: {kagome::tokenizer::TokenizeMode::Normal, kagome::tokenizer::TokenizeMode::Search}) {
+        for (const auto &body: bodies) {
+            auto expected = plain.analyze(body, mode);
+            auto tokens = cached.analyze(body, mode);
+            assert(tokens.size() == expected.size());
+            for (std::size_t i = 0; i < tokens.size(); ++i) {
+                assert(tokens[i] == expected[i]);
+            }
+            
+            auto view = cached.analyze_view(body, mode);
+            assert(view.size() == expected.size());
+            for (std::size_t i = 0; i < view.size(); ++i) {
+                assert(view.to_token(i) == expected[i]);
+                assert(view[i].surface().empty() || view[i].surface().data() == body.data() + view[i].start());
+            }
+        }
+    }
+    
+    // The footer is analyzed once per mode and spliced in everywhere else
+    auto stats = cache->stats();
+    assert(stats.hits > 0);
+    assert(stats.insertions == stats.misses);
+    
+    // A sentence above the chunk size limit is not cut where the limit
+    // falls: the cache changes nothing about the token stream
+    config.max_chunk_bytes = 64;
+    kagome::tokenizer::Tokenizer small_plain(dict, config);
+    kagome::tokenizer::Tokenizer small_cached(dict, config);
+    small_cached.set_chunk_cache(cache);
+    std::string long_text;
+    for (int i = 0; i < 20; ++i) {
+        long_text += "東京都に住んでいます、abc 123 ";
+    }
+    long_text += "今日は晴れです。" + footer;
+    assert(long_text.size() > 10 * config.max_chunk_bytes);
+    
+    for (auto mode: {kagome::tokenizer::TokenizeMode::Normal, kagome::tokenizer::TokenizeMode::Search}) {
+        for (int round = 0; round < 2; ++round) {
+            auto expected = small_plain.analyze(long_text, mode);
+            auto tokens = small_cached.analyze(long_text, mode);
+            assert(tokens.size() == expected.size());
+            for (std::size_t i = 0; i < tokens.size(); ++i) {
+                assert(tokens[i].id() == expected[i].id());
+                assert(tokens[i].index() == expected[i].index());
+                assert(tokens[i].start() == expected[i].start());
+                assert(tokens[i].end() == expected[i].end());
+                assert(tokens[i].surface() == expected[i].surface());
+            }
+        }
+    }
+    
+    std::cout << "✓ Chunk cache test passed\n";
+}
+
+void test_hash_bytes() {
+    std::cout << "Testing byte string hash...\n";
+    
+    // Reference values of wyhash final4; callers may store these hashes
+    struct KnownAnswer {
+        std::string_view bytes;
+        std::uint64_t seed;
+        std::uint64_t hash;
+    };
+    const KnownAnswer answers[] = {
+        {"", 0, 0x0409638ee2bde459ULL},
+        {"a", 1, 0xa8412d091b5fe0a9ULL},
+        {"abc", 2, 0x32dd92e4b2915153ULL},
+        {"message digest", 3, 0x8619124089a3a16bULL},
+        {"abcdefghijklmnopqrstuvwxyz", 4, 0x7a43afb61d7f5f40ULL},
+        {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", 5, 0xff42329b90e50d58ULL},
+        {"12345678901234567890123456789012345678901234567890123456789012345678901234567890", 6,
+         0xc39cab13b115aad3ULL},
+    };
+    for (const auto &answer: answers) {
+        assert(kagome::common::wyhash(answer.bytes, answer.seed, kagome::common::HASH_SECRET) == answer.hash);
+    }
+    assert(kagome::common::hash_bytes("") == 0x0409638ee2bde459ULL);
+    
+    std::cout << "✓ Byte string hash test passed\n";
+}
+
+void test_normalized_hash() {
+    std::cout << "Testing normalized form hashes...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    kagome::tokenizer::Tokenizer tokenizer(dict);
+    
+    std::string text = "東京都に住んでいました。abc 123";
+    auto result = tokenizer.analyze_view(text, kagome::tokenizer::TokenizeMode::Normal);
+    assert(!result.empty());
+    
+    // Precomputed base form hashes agree with hashing the normalized form
+    assert(dict->base_form_hashes.size() == dict->base_form_pool.size());
+    for (const auto &token: result) {
+        auto normalized = token.normalized_view();
+        auto base_form = token.base_form_view();
+        if (base_form.empty() || base_form == "*") {
+            assert(normalized == token.surface());
+        } else {
+            assert(normalized == base_form);
+        }
+        assert(token.normalized_hash() == kagome::common::hash_bytes(normalized));
+    }
+    
+    // Forms are delimited by length only, as the C API hands them out:
+    // one falling back to the surface views the input, and the byte after
+    // it is the following text rather than a terminator
+    bool found = false;
+    for (const auto &token: result) {
+        auto normalized = token.normalized_view();
+        if (normalized.empty() || normalized.data() != token.surface().data() ||
+            static_cast<std::size_t>(token.end()) == text.size()) {
+            continue;
+        }
+        assert(std::string(normalized.data(), normalized.size()) == std::string(token.surface()));
+        assert(normalized.data()[normalized.size()] == text[static_cast<std::size_t>(token.end())]);
+        assert(normalized.data()[normalized.size()] != '\0');
+        found = true;
+    }
+    assert(found);
+    
+    std::cout << "✓ Normalized hash test passed\n";
+}
+
+void test_analysis_budget() {
+    std::cout << "Testing analysis budget...\n";
+    
+    auto dict = kagome::dict::factory::create_ipa_dict();
+    std::string text = "東京都に住んでいました。今日は良い天気です。";
+    
+    kagome::tokenizer::Tokenizer unlimited(dict);
+    auto full = unlimited.analyze_view(text, kagome::tokenizer::TokenizeMode::Normal);
+    assert(!full.degraded());
+    
+    kagome::tokenizer::TokenizerConfig config;
+    config.max_edges = 1;
+    kagome::tokenizer::Tokenizer limited(dict, config);
+    auto result = limited.analyze_view(text, kagome::tokenizer::TokenizeMode::Normal);
+    assert(result.degraded());
+    
+    // The fallback still covers the whole input without gaps
+    std::size_t pos = 0;
+    for (const auto &token: result) {
+        if (token.surface().empty()) {
+            continue;
+        }
+        assert(static_cast<std::size_t>(token.start()) == pos);
+        pos += token.surface().size();
+    }
+    assert(pos == text.size());
+
+    // The owning entry points report the same state
+    bool degraded = false;
+    auto tokens = limited.analyze(text, kagome::tokenizer::TokenizeMode::Normal, &degraded);
+    assert(degraded);
+    assert(tokens.size() == result.size());
+    degraded = false;
+    auto surfaces = limited.tokenize(text, &degraded);
+    assert(degraded);
+    assert(surfaces.size() == tokens.size());
+    degraded = false;
+    limited.analyze_stream(text, kagome::tokenizer::TokenizeMode::Normal,
+                           [](kagome::tokenizer::Token &&) {}, &degraded);
+    assert(degraded);
+    auto unlimited_tokens = unlimited.analyze(text, kagome::tokenizer::TokenizeMode::Normal, &degraded);
+    assert(!degraded);
+    assert(!unlimited_tokens.empty());
+
+    // So do the pool-based ones, per document for batches
+    kagome::common::ThreadPool pool(2);
+    auto parallel = limited.analyze_parallel(text, kagome::tokenizer::TokenizeMode::Normal, pool, &degraded);
+    assert(degraded && !parallel.empty());
+    std::vector<std::string_view> documents{text, ""};
+    bool batch_degraded[2] = {false, true};
+    auto batch = limited.analyze_batch(documents, kagome::tokenizer::TokenizeMode::Normal, pool, batch_degraded);
+    assert(batch.size() == 2 && batch_degraded[0] && !batch_degraded[1]);
+    batch = unlimited.analyze_batch(documents, kagome::tokenizer::TokenizeMode::Normal, pool, batch_degraded);
+    assert(!batch_degraded[0] && !batch_degraded[1]);
+
+    // A generous time budget changes nothing
+    config.max_edges = 0;
+    config.time_budget = std::chrono::seconds(10);
+    kagome::tokenizer::Tokenizer timed(dict, config);
+    auto timed_result = timed.analyze_view(text, kagome::tokenizer::TokenizeMode::Normal);
+    assert(!timed_result.degraded());
+    assert(timed_result.size() == full.size());
+    
+    std::cout << "✓ Analysis budget test passed\n";
+}
+
+void test_normalization() {
+    std::cout << "Testing NFKC normalization...\n";
+    
+    // Normalized text is not copied
+    kagome::common::NormalizedText normalized;
+    std::string plain = "東京タワーへ行きました。abc 123";
+    kagome::common::normalize_nfkc(plain, normalized);
+    assert(!normalized.changed());
+    assert(normalized.text().data() == plain.data());
+    
+    // Full-width Latin and half-width katakana (with voiced marks) fold
+    std::string text = "ＦＲＥＥのｶﾞｲﾄﾞです";
+    kagome::common::normalize_nfkc(text, normalized);
+    assert(normalized.changed());
+    assert(normalized.text() == "FREEのガイドです");
+    assert(normalized.original_start(1) == 3);
+    assert(normalized.original_end(4) == 12);
+    // ガ is two half-width characters of 3 bytes each
+    auto ga = normalized.text().find("ガ");
+    auto ga_start = normalized.original_start(static_cast<std::int32_t>(ga));
+    auto ga_end = normalized.original_end(static_cast<std::int32_t>(ga + 3));
+    assert(text.substr(ga_start, ga_end - ga_start) == "ｶﾞ");
+    assert(normalized.original_end(static_cast<std::int32_t>(normalized.text().size())) ==
+           static_cast<std::int32_t>(text.size()));
+    
+    // The tokenizer segments the normalized form but reports original bytes
+    kagome::tokenizer::TokenizerConfig config;
+    config.omit_bos_eos = true;
+    kagome::tokenizer::Tokenizer plain_tokenizer(kagome::dict::factory::create_ipa_dict(), config);
+    config.normalize = true;
+    kagome::tokenizer::Tokenizer tokenizer(kagome::dict::factory::create_ipa_dict(), config);
+    
+    auto expected = plain_tokenizer.analyze_view(normalized.text(), kagome::tokenizer::TokenizeMode::Normal);
+    auto result = tokenizer.analyze_view(text, kagome::tokenizer::TokenizeMode::Normal);
+    assert(result.size() == expected.size());
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        const auto &token = result[i];
+        assert(token.id() == expected[i].id());
+        assert(static_cast<std::size_t>(token.start()) == pos);
+        assert(token.surface().data() == text.data() + token.start());
+        // Normalized forms and their hashes are those of the NFKC text
+        assert(token.normalized_view() == expected[i].normalized_view());
+        assert(token.normalized_hash() == expected[i].normalized_hash());
+        pos = static_cast<std::size_t>(token.end());
+    }
+    assert(pos == text.size());
+
+    // A full-width word the dictionary does not know is reported in NFKC
+    std::string unknown = "ＸＹＺＺＹ";
+    auto unknown_result = tokenizer.analyze_view(unknown, kagome::tokenizer::TokenizeMode::Normal);
+    auto unknown_expected = plain_tokenizer.analyze_view("XYZZY", kagome::tokenizer::TokenizeMode::Normal);
+    assert(unknown_result.size() == unknown_expected.size());
+    std::string folded;
+    for (std::size_t i = 0; i < unknown_result.size(); ++i) {
+        const auto &word = unknown_result[i];
+        assert(word.token_class() == kagome::tokenizer::TokenClass::Unknown);
+        assert(word.surface().data() == unknown.data() + word.start());
+        assert(word.rewritten() && word.normalized_surface() == unknown_expected[i].surface());
+        assert(word.normalized_view() == unknown_expected[i].surface());
+        assert(word.normalized_hash() == kagome::common::hash_bytes(unknown_expected[i].surface()));
+        folded += word.normalized_view();
+    }
+    assert(folded == "XYZZY");
+
+    // Visitors see the same forms while the token is passed to them
+    auto lattice = tokenizer.create_lattice();
+    std::vector<std::uint64_t> visited_hashes;
+    tokenizer.visit(*lattice, unknown, kagome::tokenizer::TokenizeMode::Normal,
+                    [&](const kagome::tokenizer::TokenView &token) {
+                        if (!token.surface().empty()) {
+                            visited_hashes.push_back(token.normalized_hash());
+                        }
+                    });
+    assert(visited_hashes.size() == unknown_result.size());
+    for (std::size_t i = 0; i < visited_hashes.size(); ++i) {
+        assert(visited_hashes[i] == unknown_result[i].normalized_hash());
+    }
+
+    auto stream_tokens = tokenizer.tokenize(text);
+    assert(stream_tokens.size() == result.size());
+    assert(stream_tokens.front().surface() == result[0].surface());
+    
+    std::cout << "✓ Normalization test passed\n";
+}
+
+void test_visit_tokens() {
+    std::cout << "Testing token visitor...\n";
+    
+    kagome::tokenizer::TokenizerConfig config;
+    config.script_prepass = true;
+    kagome::tokenizer::Tokenizer tokenizer(kagome::dict::factory::create_ipa_dict(), config);
+    auto lattice = tokenizer.create_lattice();
+    
+    // The reference is the owning analysis over the whole lattice
+    kagome::tokenizer::Tokenizer reference(kagome::dict::factory::create_ipa_dict());
+    std::string text = "東京都に住んでいました。Hello 世界!";
+    auto expected = reference.analyze(text, kagome::tokenizer::TokenizeMode::Normal);
+    
+    // Visitors are plain function objects; tokens arrive in path order
+    std::size_t visited = 0;
+    bool same = true;
+    tokenizer.visit(*lattice, text, kagome::tokenizer::TokenizeMode::Normal,
+                    [&](const kagome::tokenizer::TokenView &token) {
+                        const auto &other = expected[visited++];
+                        same = same && token.id() == other.id() && token.start() == other.start() &&
+                               token.end() == other.end() && token.token_class() == other.token_class() &&
+                               token.surface() == other.surface() && token.flags() == other.view().flags() &&
+                               (token.surface().empty() || token.surface().data() == text.data() + token.start());
+                    });
+    assert(same);
+    assert(visited == expected.size());
+    assert(!lattice->budget_exceeded());
+    
+    std::cout << "✓ Token visitor test passed\n";
+}
+
 void run_all_tests() {
     std::cout << "Running kagome C++ tokenizer tests...\n\n";
     
@@ -124,6 +1065,25 @@ void run_all_tests() {
         test_wakati_mode();
         test_different_modes();
         test_token_features();
+        test_streaming_tokenization();
+        test_parallel_tokenization();
+        test_batch_tokenization();
+        test_script_prepass();
+        test_category_scanner();
+        test_token_views();
+        test_entry_flags();
+        test_base_form_pool();
+        test_lattice_input_views();
+        test_script_detection();
+        test_lattice_reuse();
+        test_user_dict_and_beam();
+        test_result_cache();
+        test_chunk_cache();
+        test_hash_bytes();
+        test_normalized_hash();
+        test_analysis_budget();
+        test_normalization();
+        test_visit_tokens();
         
         std::cout << "\n✓ All tests passed!\n";
     } catch (const std::exception& e) {